@@ -0,0 +1,606 @@
+/**
+ * Latency and throughput benchmark for FastDelivery
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    fastdelivery_bench --subscribers 1,16,256 --payload 64,4096 --mode all
+ *    fastdelivery_bench --mode mailbox --pub-cpu 0 --sub-cpu 2
+ *
+ * The cas mode is the baseline: a copy of the original busy-wait CAS
+ * publisher, that is compared with the direct mode of the current one.
+ * It always uses a std::list, so it is only run with --storage list.
+ */
+
+#include "FastDelivery.h"
+#include "arg.h"
+#include "format.h"
+#include "string_utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+using namespace Tools;
+using namespace Tools::FastDelivery;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t MAX_STATIC_SUBSCRIBERS = 1024;
+const size_t MAX_SAMPLES = 2000000;
+const size_t BATCH_SIZE = 64;
+const size_t MAILBOX_SIZE = 1024;
+
+inline uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now().time_since_epoch() ).count();
+}
+
+void pin_current_thread( int cpu )
+{
+	if( cpu < 0 ) {
+		return;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+
+	int rv = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+
+	if( rv != 0 ) {
+		std::cerr << format( "cannot pin thread to cpu %d: %s", cpu, strerror(rv) ) << std::endl;
+	}
+}
+
+template<size_t SIZE>
+struct Payload
+{
+	uint64_t timestamp = 0;
+	char data[SIZE > sizeof(uint64_t) ? SIZE - sizeof(uint64_t) : 1] = {};
+};
+
+struct Config
+{
+	std::string mode;
+	std::string storage;
+	size_t subscribers = 1;
+	size_t payload = 64;
+	size_t messages = 100000;
+	int pub_cpu = -1;
+	int sub_cpu = -1;
+};
+
+struct Samples
+{
+	std::vector<uint32_t> latencies;
+	size_t stride = 1;
+	size_t count = 0;
+
+	// expected: samples of this node, total: samples of all nodes
+	void setup( size_t expected, size_t total ) {
+		stride = std::max<size_t>( 1, total / MAX_SAMPLES );
+		latencies.reserve( expected / stride + 1 );
+	}
+
+	void add( uint64_t sent ) {
+		if( count++ % stride == 0 ) {
+			latencies.push_back( static_cast<uint32_t>( std::min<uint64_t>( now_ns() - sent, UINT32_MAX ) ) );
+		}
+	}
+};
+
+struct Result
+{
+	double p50 = 0;
+	double p99 = 0;
+	double p999 = 0;
+	double msg_per_sec = 0;
+};
+
+double percentile( std::vector<uint32_t> & v, double p )
+{
+	if( v.empty() ) {
+		return 0;
+	}
+
+	size_t pos = std::min( v.size() - 1, static_cast<size_t>( v.size() * p ) );
+	std::nth_element( v.begin(), v.begin() + pos, v.end() );
+	return v[pos];
+}
+
+template<class NodeType>
+Result evaluate( std::vector<std::unique_ptr<NodeType>> & nodes, const Config & config, uint64_t elapsed_ns )
+{
+	std::vector<uint32_t> all;
+
+	for( auto & node : nodes ) {
+		all.insert( all.end(), node->samples.latencies.begin(), node->samples.latencies.end() );
+	}
+
+	Result res;
+	res.p50 = percentile( all, 0.5 );
+	res.p99 = percentile( all, 0.99 );
+	res.p999 = percentile( all, 0.999 );
+	res.msg_per_sec = config.messages / ( elapsed_ns / 1e9 );
+	return res;
+}
+
+// payload is copied into the node, delivered on the publisher thread
+template<class DataType>
+struct DirectNode : public PublisherNode<DataType>
+{
+	Samples samples;
+	DataType last;
+
+	void deliver( const DataType & data ) {
+		samples.add( data.timestamp );
+		last = data;
+	}
+};
+
+// only the handle is copied
+template<class DataType>
+struct SharedNode : public PublisherNode<SharedPayload<DataType>>
+{
+	Samples samples;
+	SharedPayload<DataType> last;
+
+	void deliver( const SharedPayload<DataType> & data ) {
+		samples.add( data->timestamp );
+		last = data;
+	}
+};
+
+template<class DataType>
+struct MailboxNode : public MailboxPublisherNode<DataType,MAILBOX_SIZE>
+{
+	Samples samples;
+};
+
+/**
+ * The original FastDelivery design: every delivery and the
+ * destruction of a node is guarded by a busy-wait CAS loop.
+ */
+struct CasEntry
+{
+	std::atomic<bool> operation_in_progress = false;
+	std::atomic<void*> node = nullptr;
+
+	CasEntry( void *node_ )
+	: node( node_ )
+	{}
+};
+
+template<class DataType>
+struct CasNode
+{
+	Samples samples;
+	DataType last;
+	CasEntry *registry = nullptr;
+
+	~CasNode() {
+		if( registry ) {
+			bool op = registry->operation_in_progress;
+
+			while( op ) {
+				op = registry->operation_in_progress;
+			}
+
+			while( !registry->operation_in_progress.compare_exchange_weak( op, true ) );
+
+			void *node = registry->node;
+
+			while( !registry->node.compare_exchange_weak( node, nullptr ) );
+		}
+	}
+
+	void setRegistry( CasEntry *registry_ ) {
+		registry = registry_;
+	}
+
+	void deliver( const DataType & data ) {
+		samples.add( data.timestamp );
+		last = data;
+	}
+};
+
+template<class DataType, class Node>
+class CasPublisher
+{
+	std::list<CasEntry> nodes;
+
+public:
+	void subscribe( Node *node ) {
+		CasEntry & nle = nodes.emplace_back( node );
+		node->setRegistry( &nle );
+	}
+
+	void distribute( const DataType & data ) {
+		for( auto & nle : nodes ) {
+			bool op = nle.operation_in_progress;
+
+			if( op ) {
+				continue;
+			}
+
+			while( !nle.operation_in_progress.compare_exchange_weak( op, true ) );
+
+			if( void *node = nle.node ) {
+				static_cast<Node*>( node )->deliver( data );
+			}
+
+			while( !nle.operation_in_progress.compare_exchange_weak( op, false ) );
+		}
+	}
+};
+
+template<class NodeType, class PublisherType>
+std::vector<std::unique_ptr<NodeType>> create_nodes( PublisherType & publisher, const Config & config, size_t samples_per_node )
+{
+	std::vector<std::unique_ptr<NodeType>> nodes;
+
+	for( size_t i = 0; i < config.subscribers; ++i ) {
+		nodes.push_back( std::make_unique<NodeType>() );
+		nodes.back()->samples.setup( samples_per_node, samples_per_node * config.subscribers );
+		publisher.subscribe( nodes.back().get() );
+	}
+
+	return nodes;
+}
+
+template<class DataType, class List>
+Result run_direct( const Config & config )
+{
+	Publisher<DataType,DirectNode<DataType>,List> publisher;
+	auto nodes = create_nodes<DirectNode<DataType>>( publisher, config, config.messages );
+
+	pin_current_thread( config.pub_cpu );
+
+	DataType data;
+	const uint64_t start = now_ns();
+
+	for( size_t i = 0; i < config.messages; ++i ) {
+		data.timestamp = now_ns();
+		publisher.distribute( data );
+	}
+
+	return evaluate( nodes, config, now_ns() - start );
+}
+
+template<class DataType>
+Result run_cas( const Config & config )
+{
+	CasPublisher<DataType,CasNode<DataType>> publisher;
+	auto nodes = create_nodes<CasNode<DataType>>( publisher, config, config.messages );
+
+	pin_current_thread( config.pub_cpu );
+
+	DataType data;
+	const uint64_t start = now_ns();
+
+	for( size_t i = 0; i < config.messages; ++i ) {
+		data.timestamp = now_ns();
+		publisher.distribute( data );
+	}
+
+	return evaluate( nodes, config, now_ns() - start );
+}
+
+template<class DataType, class List>
+Result run_shared( const Config & config )
+{
+	Publisher<SharedPayload<DataType>,SharedNode<DataType>,List> publisher;
+	auto nodes = create_nodes<SharedNode<DataType>>( publisher, config, config.messages );
+
+	pin_current_thread( config.pub_cpu );
+
+	const uint64_t start = now_ns();
+
+	for( size_t i = 0; i < config.messages; ++i ) {
+		DataType data;
+		data.timestamp = now_ns();
+		publisher.distribute( make_shared_payload<DataType>( data ) );
+	}
+
+	return evaluate( nodes, config, now_ns() - start );
+}
+
+template<class DataType, class List>
+Result run_batch( const Config & config )
+{
+	Publisher<DataType,DirectNode<DataType>,List> publisher;
+	auto nodes = create_nodes<DirectNode<DataType>>( publisher, config, config.messages );
+
+	pin_current_thread( config.pub_cpu );
+
+	std::vector<DataType> batch( BATCH_SIZE );
+	const uint64_t start = now_ns();
+
+	for( size_t i = 0; i < config.messages; i += BATCH_SIZE ) {
+		const size_t count = std::min( BATCH_SIZE, config.messages - i );
+		const uint64_t ts = now_ns();
+
+		for( size_t j = 0; j < count; ++j ) {
+			batch[j].timestamp = ts;
+		}
+
+		publisher.distribute( std::span<const DataType>( batch.data(), count ) );
+	}
+
+	return evaluate( nodes, config, now_ns() - start );
+}
+
+template<class DataType, class List>
+Result run_mailbox( const Config & config )
+{
+	Publisher<DataType,MailboxNode<DataType>,List> publisher;
+	auto nodes = create_nodes<MailboxNode<DataType>>( publisher, config, config.messages );
+
+	std::atomic<bool> stop = false;
+
+	// one subscriber thread drains all mailboxes
+	std::thread subscriber( [&nodes, &stop, &config]() {
+		pin_current_thread( config.sub_cpu );
+
+		while( true ) {
+			const bool last_round = stop.load();
+			size_t count = 0;
+
+			for( auto & node : nodes ) {
+				count += node->drain( [&node]( const DataType & data ) {
+					node->samples.add( data.timestamp );
+				});
+			}
+
+			if( last_round && count == 0 ) {
+				break;
+			}
+		}
+	});
+
+	pin_current_thread( config.pub_cpu );
+
+	DataType data;
+	const uint64_t start = now_ns();
+
+	for( size_t i = 0; i < config.messages; ++i ) {
+		data.timestamp = now_ns();
+		publisher.distribute( data );
+	}
+
+	stop = true;
+	subscriber.join();
+
+	const uint64_t elapsed = now_ns() - start;
+
+	size_t dropped = 0;
+	for( auto & node : nodes ) {
+		dropped += node->getStatistics().dropped;
+	}
+
+	if( dropped ) {
+		std::cout << format( "  mailbox dropped %d messages", dropped ) << std::endl;
+	}
+
+	return evaluate( nodes, config, elapsed );
+}
+
+template<class DataType, class List>
+Result run_mode( const Config & config )
+{
+	if( config.mode == "cas" ) {
+		return run_cas<DataType>( config );
+	} else if( config.mode == "direct" ) {
+		return run_direct<DataType,List>( config );
+	} else if( config.mode == "shared" ) {
+		return run_shared<DataType,List>( config );
+	} else if( config.mode == "batch" ) {
+		return run_batch<DataType,List>( config );
+	}
+
+	// the modes are checked in main()
+	return run_mailbox<DataType,List>( config );
+}
+
+template<size_t SIZE>
+Result run_storage( const Config & config )
+{
+	if( config.storage == "static" ) {
+		return run_mode<Payload<SIZE>,StaticNodeList<MAX_STATIC_SUBSCRIBERS>>( config );
+	}
+
+	return run_mode<Payload<SIZE>,std::list<NodeListEntry>>( config );
+}
+
+bool run( const Config & config, Result & res )
+{
+	switch( config.payload )
+	{
+	case 16:    res = run_storage<16>( config ); return true;
+	case 64:    res = run_storage<64>( config ); return true;
+	case 256:   res = run_storage<256>( config ); return true;
+	case 1024:  res = run_storage<1024>( config ); return true;
+	case 4096:  res = run_storage<4096>( config ); return true;
+	case 16384: res = run_storage<16384>( config ); return true;
+	}
+
+	std::cerr << format( "unsupported payload size: %d (16, 64, 256, 1024, 4096, 16384)", config.payload ) << std::endl;
+	return false;
+}
+
+std::vector<std::string> get_list( const Arg::StringOption & option, const std::string & def )
+{
+	if( option.isSet() ) {
+		return split_simple( option.getValues()->at(0), "," );
+	}
+
+	return split_simple( def, "," );
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+	Arg::Arg arg( argc, argv );
+	arg.addPrefix( "-" );
+	arg.addPrefix( "--" );
+
+	Arg::OptionChain oc_info;
+	arg.addChainR( &oc_info );
+	oc_info.setMinMatch( 1 );
+	oc_info.setContinueOnMatch( false );
+	oc_info.setContinueOnFail( true );
+
+	Arg::FlagOption o_help( "help" );
+	o_help.setDescription( "Show this page" );
+	oc_info.addOptionR( &o_help );
+
+	Arg::OptionChain oc_bench;
+	arg.addChainR( &oc_bench );
+	oc_bench.setMinMatch( 0 );
+	oc_bench.setContinueOnMatch( true );
+	oc_bench.setContinueOnFail( true );
+
+	Arg::StringOption o_subscribers( "subscribers" );
+	o_subscribers.setDescription( "comma separated list of subscriber counts (default 1,16,256)" );
+	o_subscribers.setRequired( false );
+	o_subscribers.setMinValues( 1 );
+	o_subscribers.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_subscribers );
+
+	Arg::StringOption o_payload( "payload" );
+	o_payload.setDescription( "comma separated list of payload sizes in bytes (default 64,4096)" );
+	o_payload.setRequired( false );
+	o_payload.setMinValues( 1 );
+	o_payload.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_payload );
+
+	Arg::StringOption o_storage( "storage" );
+	o_storage.setDescription( "list, static or all (default all)" );
+	o_storage.setRequired( false );
+	o_storage.setMinValues( 1 );
+	o_storage.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_storage );
+
+	Arg::StringOption o_mode( "mode" );
+	o_mode.setDescription( "cas, direct, batch, shared, mailbox or all (default all)" );
+	o_mode.setRequired( false );
+	o_mode.setMinValues( 1 );
+	o_mode.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_mode );
+
+	Arg::IntOption o_messages( "messages" );
+	o_messages.setDescription( "messages per run (default 100000)" );
+	o_messages.setRequired( false );
+	o_messages.setMinValues( 1 );
+	o_messages.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_messages );
+
+	Arg::IntOption o_pub_cpu( "pub-cpu" );
+	o_pub_cpu.setDescription( "pin the publisher thread to this cpu" );
+	o_pub_cpu.setRequired( false );
+	o_pub_cpu.setMinValues( 1 );
+	o_pub_cpu.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_pub_cpu );
+
+	Arg::IntOption o_sub_cpu( "sub-cpu" );
+	o_sub_cpu.setDescription( "pin the subscriber thread to this cpu (mailbox mode)" );
+	o_sub_cpu.setRequired( false );
+	o_sub_cpu.setMinValues( 1 );
+	o_sub_cpu.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_sub_cpu );
+
+	if( !arg.parse() || o_help.getState() ) {
+		std::cout << arg.getHelp( 5, 20, 30, 80 ) << std::endl;
+		return o_help.getState() ? 0 : 1;
+	}
+
+	Config config;
+
+	if( o_messages.isSet() ) {
+		config.messages = s2x<size_t>( o_messages.getValues()->at(0), config.messages );
+	}
+
+	if( o_pub_cpu.isSet() ) {
+		config.pub_cpu = s2x<int>( o_pub_cpu.getValues()->at(0), -1 );
+	}
+
+	if( o_sub_cpu.isSet() ) {
+		config.sub_cpu = s2x<int>( o_sub_cpu.getValues()->at(0), -1 );
+	}
+
+	std::vector<std::string> modes = get_list( o_mode, "all" );
+	std::vector<std::string> storages = get_list( o_storage, "all" );
+
+	const std::vector<std::string> all_modes = { "cas", "direct", "batch", "shared", "mailbox" };
+
+	if( modes.size() == 1 && modes[0] == "all" ) {
+		modes = all_modes;
+	}
+
+	for( const std::string & mode : modes ) {
+		if( std::find( all_modes.begin(), all_modes.end(), mode ) == all_modes.end() ) {
+			std::cerr << format( "unknown mode: '%s'", mode ) << std::endl;
+			std::cout << arg.getHelp( 5, 20, 30, 80 ) << std::endl;
+			return 1;
+		}
+	}
+
+	if( storages.size() == 1 && storages[0] == "all" ) {
+		storages = { "list", "static" };
+	}
+
+	for( const std::string & storage : storages ) {
+		if( storage != "list" && storage != "static" ) {
+			std::cerr << format( "unknown storage: '%s'", storage ) << std::endl;
+			std::cout << arg.getHelp( 5, 20, 30, 80 ) << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << format( "%-8s %-7s %6s %7s %10s %10s %10s %14s",
+						 "mode", "storage", "subs", "payload", "p50[ns]", "p99[ns]", "p99.9[ns]", "msg/s" ) << std::endl;
+
+	for( const std::string & mode : modes ) {
+		for( const std::string & storage : storages ) {
+			for( const std::string & subscribers : get_list( o_subscribers, "1,16,256" ) ) {
+				for( const std::string & payload : get_list( o_payload, "64,4096" ) ) {
+
+					config.mode = mode;
+					config.storage = storage;
+					config.subscribers = s2x<size_t>( subscribers, 1 );
+					config.payload = s2x<size_t>( payload, 64 );
+
+					if( storage == "static" && config.subscribers > MAX_STATIC_SUBSCRIBERS ) {
+						continue;
+					}
+
+					// the baseline has no StaticNodeList
+					if( storage == "static" && mode == "cas" ) {
+						continue;
+					}
+
+					Result res;
+
+					if( !run( config, res ) ) {
+						return 1;
+					}
+
+					std::cout << format( "%-8s %-7s %6d %7d %10.0f %10.0f %10.0f %14.0f",
+										 mode, storage, config.subscribers, config.payload,
+										 res.p50, res.p99, res.p999, res.msg_per_sec ) << std::endl;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
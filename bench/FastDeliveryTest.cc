@@ -0,0 +1,101 @@
+/**
+ * Regression checks for FastDelivery
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Returns 0 if all checks passed. Best run with -fsanitize=address.
+ */
+
+#include "FastDelivery.h"
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+using namespace Tools::FastDelivery;
+
+namespace {
+
+int failures = 0;
+
+void check( bool ok, const char *what )
+{
+	if( !ok ) {
+		std::cerr << "FAILED: " << what << std::endl;
+		failures++;
+	}
+}
+
+struct Counter : public PublisherNode<int>
+{
+	size_t received = 0;
+
+	~Counter() {
+		unsubscribe();
+	}
+
+	void deliver( const int & ) {
+		received++;
+	}
+};
+
+// a node subscribed to a second topic must not leave a dangling entry behind
+void subscribe_two_topics()
+{
+	TopicPublisher<int,std::string,Counter> publisher;
+
+	{
+		Counter node;
+		publisher.subscribe( &node, "A" );
+
+		bool thrown = false;
+
+		try {
+			publisher.subscribe( &node, "B" );
+		} catch( const std::logic_error & ) {
+			thrown = true;
+		}
+
+		check( thrown, "second subscribe throws" );
+
+		thrown = false;
+
+		try {
+			publisher.subscribe_all( &node );
+		} catch( const std::logic_error & ) {
+			thrown = true;
+		}
+
+		check( thrown, "subscribe_all of a subscribed node throws" );
+
+		publisher.distribute( "A", 1 );
+		publisher.distribute( "B", 2 );
+		check( node.received == 1, "only topic A delivered" );
+
+		node.unsubscribe();
+		publisher.distribute( "A", 3 );
+		check( node.received == 1, "nothing delivered after unsubscribe" );
+
+		// after unsubscribe() the node can move to an other topic
+		publisher.subscribe( &node, "B" );
+		publisher.distribute( "B", 4 );
+		check( node.received == 2, "topic B delivered after resubscribe" );
+	}
+
+	// the node is destroyed, distribute() must not touch it
+	publisher.distribute( "A", 5 );
+	publisher.distribute( "B", 6 );
+}
+
+} // namespace
+
+int main()
+{
+	subscribe_two_topics();
+
+	if( failures ) {
+		return 1;
+	}
+
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
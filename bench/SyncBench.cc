@@ -0,0 +1,283 @@
+/**
+ * Benchmark of the Tools:: synchronization primitives
+ * against their std:: counterparts
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    sync_bench --threads 2,4,8 --rounds 100000
+ *    sync_bench --mode barrier
+ */
+
+#include "sync.h"
+#include "arg.h"
+#include "format.h"
+#include "string_utils.h"
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+using namespace Tools;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Config
+{
+	size_t threads = 2;
+	size_t rounds = 100000;
+};
+
+// runs func(idx) on config.threads threads, returns the nanoseconds per round
+double measure( const Config & config, const std::function<void(size_t)> & func )
+{
+	std::vector<std::thread> threads;
+
+	auto start = Clock::now();
+
+	for( size_t i = 0; i < config.threads; ++i ) {
+		threads.emplace_back( func, i );
+	}
+
+	for( std::thread & t : threads ) {
+		t.join();
+	}
+
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start ).count();
+
+	return static_cast<double>(ns) / config.rounds;
+}
+
+template <class BARRIER>
+double bench_barrier( const Config & config )
+{
+	BARRIER barrier( config.threads );
+
+	return measure( config, [&]( size_t ) {
+		for( size_t r = 0; r < config.rounds; ++r ) {
+			barrier.arrive_and_wait();
+		}
+	});
+}
+
+// a new latch per round, all threads are counting down and waiting
+template <class LATCH>
+double bench_latch( const Config & config )
+{
+	std::vector<std::unique_ptr<LATCH>> latches;
+
+	for( size_t r = 0; r < config.rounds; ++r ) {
+		latches.push_back( std::make_unique<LATCH>( config.threads ) );
+	}
+
+	return measure( config, [&]( size_t ) {
+		for( size_t r = 0; r < config.rounds; ++r ) {
+			latches[r]->arrive_and_wait();
+		}
+	});
+}
+
+// ping pong: thread 0 releases the others, they are releasing thread 0
+template <class SEMAPHORE>
+double bench_semaphore( const Config & config )
+{
+	SEMAPHORE ping( 0 );
+	SEMAPHORE pong( 0 );
+	const size_t others = config.threads > 1 ? config.threads - 1 : 1;
+	Config c = config;
+	c.threads = others + 1;
+
+	return measure( c, [&]( size_t idx ) {
+		for( size_t r = 0; r < config.rounds; ++r ) {
+			if( idx == 0 ) {
+				ping.release( others );
+
+				for( size_t i = 0; i < others; ++i ) {
+					pong.acquire();
+				}
+			} else {
+				ping.acquire();
+				pong.release();
+			}
+		}
+	});
+}
+
+class CondvarEvent
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool state = false;
+
+public:
+	void set() {
+		std::lock_guard<std::mutex> lock( mutex );
+		state = true;
+		cond.notify_all();
+	}
+
+	void reset() {
+		std::lock_guard<std::mutex> lock( mutex );
+		state = false;
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock( mutex );
+		cond.wait( lock, [this]() { return state; } );
+	}
+};
+
+// one event per round, thread 0 sets it, the others wait for it
+template <class EVENT>
+double bench_event( const Config & config )
+{
+	std::vector<std::unique_ptr<EVENT>> events;
+	std::vector<std::unique_ptr<EVENT>> acks;
+
+	for( size_t r = 0; r < config.rounds; ++r ) {
+		events.push_back( std::make_unique<EVENT>() );
+		acks.push_back( std::make_unique<EVENT>() );
+	}
+
+	return measure( config, [&]( size_t idx ) {
+		for( size_t r = 0; r < config.rounds; ++r ) {
+			if( idx == 0 ) {
+				events[r]->set();
+				acks[r]->wait();
+			} else {
+				events[r]->wait();
+				if( idx == 1 ) {
+					acks[r]->set();
+				}
+			}
+		}
+	});
+}
+
+double run( const std::string & mode, bool std_variant, const Config & config )
+{
+	typedef std::counting_semaphore<INT32_MAX> StdSemaphore;
+
+	if( mode == "barrier" ) {
+		return std_variant ? bench_barrier<std::barrier<>>( config ) : bench_barrier<Barrier<>>( config );
+	}
+
+	if( mode == "latch" ) {
+		return std_variant ? bench_latch<std::latch>( config ) : bench_latch<Latch>( config );
+	}
+
+	if( mode == "semaphore" ) {
+		return std_variant ? bench_semaphore<StdSemaphore>( config ) : bench_semaphore<CountingSemaphore>( config );
+	}
+
+	// "event", the modes are checked by main()
+	return std_variant ? bench_event<CondvarEvent>( config ) : bench_event<ManualResetEvent>( config );
+}
+
+std::vector<std::string> get_list( const Arg::StringOption & option, const std::string & def )
+{
+	if( option.isSet() ) {
+		return split_simple( option.getValues()->at(0), "," );
+	}
+
+	return split_simple( def, "," );
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+	Arg::Arg arg( argc, argv );
+	arg.addPrefix( "-" );
+	arg.addPrefix( "--" );
+
+	Arg::OptionChain oc_info;
+	arg.addChainR( &oc_info );
+	oc_info.setMinMatch( 1 );
+	oc_info.setContinueOnMatch( false );
+	oc_info.setContinueOnFail( true );
+
+	Arg::FlagOption o_help( "help" );
+	o_help.setDescription( "Show this page" );
+	oc_info.addOptionR( &o_help );
+
+	Arg::OptionChain oc_bench;
+	arg.addChainR( &oc_bench );
+	oc_bench.setMinMatch( 0 );
+	oc_bench.setContinueOnMatch( true );
+	oc_bench.setContinueOnFail( true );
+
+	Arg::StringOption o_threads( "threads" );
+	o_threads.setDescription( "comma separated list of thread counts (default 2,4)" );
+	o_threads.setRequired( false );
+	o_threads.setMinValues( 1 );
+	o_threads.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_threads );
+
+	Arg::StringOption o_mode( "mode" );
+	o_mode.setDescription( "barrier, latch, semaphore, event or all (default all)" );
+	o_mode.setRequired( false );
+	o_mode.setMinValues( 1 );
+	o_mode.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_mode );
+
+	Arg::IntOption o_rounds( "rounds" );
+	o_rounds.setDescription( "rounds per run (default 100000)" );
+	o_rounds.setRequired( false );
+	o_rounds.setMinValues( 1 );
+	o_rounds.setMaxValues( 1 );
+	oc_bench.addOptionR( &o_rounds );
+
+	if( !arg.parse() || o_help.getState() ) {
+		std::cout << arg.getHelp( 5, 20, 30, 80 ) << std::endl;
+		return o_help.getState() ? 0 : 1;
+	}
+
+	Config config;
+
+	if( o_rounds.isSet() ) {
+		config.rounds = s2x<size_t>( o_rounds.getValues()->at(0), config.rounds );
+	}
+
+	std::vector<std::string> modes = get_list( o_mode, "all" );
+	const std::vector<std::string> all_modes = { "barrier", "latch", "semaphore", "event" };
+
+	if( modes.size() == 1 && modes[0] == "all" ) {
+		modes = all_modes;
+	}
+
+	for( const std::string & mode : modes ) {
+		if( std::find( all_modes.begin(), all_modes.end(), mode ) == all_modes.end() ) {
+			std::cerr << format( "unknown mode: '%s'", mode ) << std::endl;
+			std::cout << arg.getHelp( 5, 20, 30, 80 ) << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << format( "%-10s %7s %14s %14s %8s",
+						 "mode", "threads", "tools[ns]", "std[ns]", "speedup" ) << std::endl;
+
+	for( const std::string & mode : modes ) {
+		for( const std::string & threads : get_list( o_threads, "2,4" ) ) {
+			config.threads = std::max<size_t>( 2, s2x<size_t>( threads, 2 ) );
+
+			double tools_ns = run( mode, false, config );
+			double std_ns = run( mode, true, config );
+
+			std::cout << format( "%-10s %7d %14.1f %14.1f %7.2fx",
+								 mode, config.threads, tools_ns, std_ns, std_ns / tools_ns ) << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -10,22 +10,157 @@
 #include <list>
 #include <array>
 #include <stdexcept>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <chrono>
 
 namespace Tools {
 namespace FastDelivery {
 
+/**
+ * Grace period detection for the subscriber lists.
+ *
+ * Every distribute() call is a read side critical section. A node that
+ * leaves calls synchronize(), which returns as soon as every distribute()
+ * that might still see the node has finished. The publishers are never
+ * blocked by this, only the leaving subscriber waits.
+ *
+ * Readers are counted in one of two slots, selected by the current epoch.
+ * synchronize() switches the epoch and waits until the old slot is empty.
+ */
+class EpochDomain
+{
+	struct alignas(64) ReaderSlot
+	{
+		std::atomic<unsigned> count = 0;
+	};
+
+	alignas(64) std::atomic<size_t> epoch = 0;
+	ReaderSlot readers[2];
+	alignas(64) std::atomic<bool> waiting = false;
+	std::mutex synchronize_mutex;
+
+public:
+	class ReadGuard
+	{
+		EpochDomain & domain;
+		const size_t epoch;
+
+	public:
+		ReadGuard( EpochDomain & domain_ )
+		: domain( domain_ ),
+		  epoch( domain.enter() )
+		{}
+
+		ReadGuard( const ReadGuard & other ) = delete;
+		ReadGuard & operator=( const ReadGuard & other ) = delete;
+
+		~ReadGuard() {
+			domain.leave( epoch );
+		}
+	};
+
+	EpochDomain() = default;
+	EpochDomain( const EpochDomain & other ) = delete;
+	EpochDomain & operator=( const EpochDomain & other ) = delete;
+
+	size_t enter() {
+		while( true ) {
+			const size_t e = epoch.load();
+			readers[e & 1].count.fetch_add( 1 );
+
+			// epoch switched in between, the writer may not have seen us
+			if( epoch.load() == e ) {
+				return e;
+			}
+
+			leave( e );
+		}
+	}
+
+	void leave( size_t e ) {
+		ReaderSlot & slot = readers[e & 1];
+
+		if( slot.count.fetch_sub( 1 ) == 1 && waiting.load() ) {
+			slot.count.notify_all();
+		}
+	}
+
+	// waits until all readers, that entered before, have left
+	void synchronize() {
+		std::lock_guard<std::mutex> lock( synchronize_mutex );
+
+		ReaderSlot & slot = readers[epoch.fetch_add( 1 ) & 1];
+
+		waiting.store( true );
+
+		for( unsigned count = slot.count.load(); count != 0; count = slot.count.load() ) {
+			slot.count.wait( count );
+		}
+
+		waiting.store( false );
+	}
+};
+
 struct NodeListEntry
 {
-	// will be true if construction, destruction, or delivery is in progress
-	// on any operation wait until it's false again
-	std::atomic<bool> operation_in_progress = false;
+	// the subscribed node, nullptr if the entry is currently unused
 	std::atomic<void*> node = nullptr;
 
-	NodeListEntry( void *node_ )
-	: node( node_ )
+	// the next entry the publisher is walking through
+	std::atomic<NodeListEntry*> next = nullptr;
+
+	// true as long as a node owns this entry, including
+	// the grace period after the node left
+	std::atomic<bool> in_use = false;
+
+	// will be true while a publisher thread is delivering to the node,
+	// an other publisher thread skips the node meanwhile
+	std::atomic<bool> operation_in_progress = false;
+
+	// number of distribute() calls that skipped this node,
+	// because an other operation was in progress
+	std::atomic<size_t> skipped = 0;
+
+	// deadline misses in a row, maintained by the ParallelPublisher
+	std::atomic<unsigned> deadline_misses = 0;
+
+	// the node was too slow, the ParallelPublisher
+	// delivers it through its slow lane
+	std::atomic<bool> isolated = false;
+
+	EpochDomain *epoch = nullptr;
+
+	NodeListEntry( void *node_ = nullptr, EpochDomain *epoch_ = nullptr )
+	: node( node_ ),
+	  epoch( epoch_ )
 	{
 
 	}
+
+	/**
+	 * Detaches the node. Returns after no distribute()
+	 * is accessing the node any longer.
+	 */
+	void release() {
+		node.store( nullptr );
+
+		if( epoch ) {
+			epoch->synchronize();
+		}
+
+		skipped.store( 0, std::memory_order_relaxed );
+		deadline_misses.store( 0, std::memory_order_relaxed );
+		isolated.store( false, std::memory_order_relaxed );
+		in_use.store( false );
+	}
 };
 
 
@@ -40,33 +175,455 @@ protected:
 
 public:
 	~PublisherNode() {
+		unsubscribe();
+	}
+
+	/**
+	 * Detaches the node from the publisher. Derived classes
+	 * that are delivering into own members have to call it
+	 * from their destructor.
+	 *
+	 * Do not call it from inside deliver(), it waits
+	 * until the running distribute() calls are finished.
+	 */
+	void unsubscribe() {
 		if( registry ) {
-			bool op = registry->operation_in_progress;
+			NodeListEntry *nle = registry;
+			registry = nullptr;
+			nle->release();
+		}
+	}
 
-			while( op ) {
-				op = registry->operation_in_progress;
-			}
+	void setRegistry( NodeListEntry *registry_ ) {
+		registry = registry_;
+	}
 
-			while(!registry->operation_in_progress.compare_exchange_weak( op, true ));
+	// a node can be subscribed to one publisher and topic only
+	bool isSubscribed() const {
+		return registry != nullptr;
+	}
 
-			void *node = registry->node;
+	// number of messages this node missed, because it was busy
+	size_t getSkipped() const {
+		if( registry ) {
+			return registry->skipped;
+		}
+		return 0;
+	}
+};
 
-			while(!registry->node.compare_exchange_weak( node, nullptr ));
+/**
+ * Bounded wait-free single producer single consumer queue.
+ * One thread may call push(), one other thread may call pop().
+ */
+template <class DataType, size_t N>
+class SpscMailbox
+{
+	static_assert( N > 0, "capacity has to be at least 1" );
 
-			registry = nullptr;
+	// producer and consumer indexes are on different cache lines
+	alignas(64) std::atomic<size_t> head = 0; // next position to read
+	alignas(64) std::atomic<size_t> tail = 0; // next position to write
+	alignas(DataType) std::byte buffer[sizeof(DataType)*N];
+
+public:
+	typedef DataType value_type;
+
+	SpscMailbox() = default;
+	SpscMailbox( const SpscMailbox & other ) = delete;
+	SpscMailbox & operator=( const SpscMailbox & other ) = delete;
+
+	~SpscMailbox() {
+		for( size_t h = head; h != tail; ++h ) {
+			slot(h)->~DataType();
 		}
 	}
 
-	void setRegistry( NodeListEntry *registry_ ) {
-		registry = registry_;
+	constexpr size_t capacity() const {
+		return N;
+	}
+
+	// producer side, returns false if the mailbox is full
+	template<class T>
+	bool push( T && data ) {
+		const size_t t = tail.load( std::memory_order_relaxed );
+
+		if( t - head.load( std::memory_order_acquire ) >= N ) {
+			return false;
+		}
+
+		new (slot(t)) DataType( std::forward<T>(data) );
+		tail.store( t + 1, std::memory_order_release );
+		return true;
+	}
+
+	/**
+	 * producer side, enqueues as many elements as fit into the mailbox,
+	 * the consumer sees them all at once.
+	 * returns the number of enqueued elements
+	 */
+	size_t push_batch( std::span<const DataType> data ) {
+		const size_t t = tail.load( std::memory_order_relaxed );
+		const size_t free_slots = N - (t - head.load( std::memory_order_acquire ));
+		const size_t count = std::min( free_slots, data.size() );
+
+		for( size_t i = 0; i < count; ++i ) {
+			new (slot(t + i)) DataType( data[i] );
+		}
+
+		tail.store( t + count, std::memory_order_release );
+		return count;
+	}
+
+	// consumer side, returns false if the mailbox is empty
+	bool pop( DataType & data ) {
+		const size_t h = head.load( std::memory_order_relaxed );
+
+		if( h == tail.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+
+		DataType *d = slot(h);
+		data = std::move(*d);
+		d->~DataType();
+		head.store( h + 1, std::memory_order_release );
+		return true;
+	}
+
+	// number of queued elements, exact only from the producer or consumer thread
+	size_t size() const {
+		return tail.load( std::memory_order_acquire ) - head.load( std::memory_order_acquire );
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+private:
+	DataType *slot( size_t pos ) {
+		return std::launder( reinterpret_cast<DataType*>( buffer + sizeof(DataType) * (pos % N) ) );
 	}
 };
 
+/**
+ * A node that does not process the data on the publisher thread.
+ * deliver() only enqueues the data into a bounded SPSC mailbox,
+ * the subscriber drains it from its own thread:
+ *
+ *  struct Quotes : public MailboxPublisherNode<Quote,1024> {};
+ *
+ *  Publisher<Quote,Quotes> publisher;
+ *  Quotes quotes;
+ *  publisher.subscribe( &quotes );
+ *
+ *  // subscriber thread
+ *  quotes.drain( []( const Quote & q ) { ... } );
+ *
+ * The mailbox has exactly one producer. If several threads are calling
+ * distribute() concurrently, a node that is busy is skipped and counted.
+ * If the mailbox is full the data is dropped and counted.
+ */
+template <class DataType, size_t N>
+class MailboxPublisherNode : public PublisherNode<DataType>
+{
+public:
+	struct Statistics
+	{
+		size_t delivered = 0;	// successfully enqueued
+		size_t dropped = 0;		// mailbox was full
+		size_t skipped = 0;		// publisher skipped the node, because it was busy
+		size_t depth = 0;		// currently queued
+		size_t max_depth = 0;	// high water mark
+	};
+
+protected:
+	SpscMailbox<DataType,N> mailbox;
+
+	// written from the publisher thread only
+	std::atomic<size_t> delivered = 0;
+	std::atomic<size_t> dropped = 0;
+	std::atomic<size_t> max_depth = 0;
+
+public:
+	~MailboxPublisherNode() {
+		// the mailbox has to stay valid until the publisher has released the node
+		PublisherNode<DataType>::unsubscribe();
+	}
+
+	// publisher side
+	void deliver( const DataType & data ) {
+		if( !mailbox.push( data ) ) {
+			dropped.store( dropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+			return;
+		}
+
+		delivered.store( delivered.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		update_max_depth();
+	}
+
+	// publisher side, a whole batch is enqueued with one release operation
+	void deliver( std::span<const DataType> data ) {
+		const size_t count = mailbox.push_batch( data );
+
+		delivered.store( delivered.load( std::memory_order_relaxed ) + count, std::memory_order_relaxed );
+
+		if( count < data.size() ) {
+			dropped.store( dropped.load( std::memory_order_relaxed ) + data.size() - count, std::memory_order_relaxed );
+		}
+
+		update_max_depth();
+	}
+
+	// subscriber side
+	bool receive( DataType & data ) {
+		return mailbox.pop( data );
+	}
+
+	/**
+	 * subscriber side, calls func() for every queued element,
+	 * but at most max_count times.
+	 * returns the number of processed elements
+	 */
+	template<class Func>
+	size_t drain( Func && func, size_t max_count = static_cast<size_t>(-1) ) {
+		size_t count = 0;
+		DataType data;
+
+		while( count < max_count && mailbox.pop( data ) ) {
+			func( data );
+			count++;
+		}
+
+		return count;
+	}
+
+	size_t depth() const {
+		return mailbox.size();
+	}
+
+	Statistics getStatistics() const {
+		Statistics stat;
+		stat.delivered = delivered.load( std::memory_order_relaxed );
+		stat.dropped = dropped.load( std::memory_order_relaxed );
+		stat.skipped = PublisherNode<DataType>::getSkipped();
+		stat.depth = mailbox.size();
+		stat.max_depth = max_depth.load( std::memory_order_relaxed );
+		return stat;
+	}
+
+protected:
+	void update_max_depth() {
+		const size_t depth = mailbox.size();
+
+		if( depth > max_depth.load( std::memory_order_relaxed ) ) {
+			max_depth.store( depth, std::memory_order_relaxed );
+		}
+	}
+};
+
+/**
+ * Immutable payload that is shared between all subscribers.
+ * The data is allocated once, together with its reference counter.
+ * Copying a SharedPayload only increments the counter, so a big DataType
+ * is never copied, regardless of the number of subscribers, or mailboxes
+ * it is queued in:
+ *
+ *   Publisher<SharedPayload<OrderBook>,Node> publisher;
+ *   publisher.distribute( make_shared_payload<OrderBook>( snapshot ) );
+ *
+ * The payload is destroyed by the last subscriber releasing it.
+ */
+template <class T>
+class SharedPayload
+{
+	struct Buffer
+	{
+		std::atomic<size_t> refs = 1;
+		const T value;
+
+		template< class... Args >
+		Buffer( Args&&... args )
+		: value( std::forward<Args>(args)... )
+		{}
+	};
+
+	Buffer *buffer = nullptr;
+
+	explicit SharedPayload( Buffer *buffer_ )
+	: buffer( buffer_ )
+	{}
+
+public:
+	typedef T element_type;
+
+	SharedPayload() = default;
+
+	SharedPayload( const SharedPayload & other )
+	: buffer( other.buffer )
+	{
+		if( buffer ) {
+			buffer->refs.fetch_add( 1, std::memory_order_relaxed );
+		}
+	}
+
+	SharedPayload( SharedPayload && other )
+	: buffer( other.buffer )
+	{
+		other.buffer = nullptr;
+	}
+
+	~SharedPayload() {
+		reset();
+	}
+
+	SharedPayload & operator=( const SharedPayload & other ) {
+		SharedPayload( other ).swap( *this );
+		return *this;
+	}
+
+	SharedPayload & operator=( SharedPayload && other ) {
+		SharedPayload( std::move(other) ).swap( *this );
+		return *this;
+	}
+
+	void swap( SharedPayload & other ) {
+		std::swap( buffer, other.buffer );
+	}
+
+	void reset() {
+		if( buffer && buffer->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+			delete buffer;
+		}
+		buffer = nullptr;
+	}
+
+	const T *get() const {
+		return buffer ? &buffer->value : nullptr;
+	}
+
+	const T & operator*() const {
+		return buffer->value;
+	}
+
+	const T *operator->() const {
+		return &buffer->value;
+	}
+
+	explicit operator bool() const {
+		return buffer != nullptr;
+	}
+
+	size_t use_count() const {
+		return buffer ? buffer->refs.load( std::memory_order_relaxed ) : 0;
+	}
+
+	template< class U, class... Args >
+	friend SharedPayload<U> make_shared_payload( Args&&... args );
+};
+
+template< class T, class... Args >
+SharedPayload<T> make_shared_payload( Args&&... args )
+{
+	return SharedPayload<T>( new typename SharedPayload<T>::Buffer( std::forward<Args>(args)... ) );
+}
+
+/**
+ * Singly linked chain of NodeListEntry objects. The chain is only
+ * appended, never shortened, so distribute() can walk it without locking.
+ * The entry of a node that left is reused after the grace period.
+ */
+class SubscriberChain
+{
+	std::atomic<NodeListEntry*> head = nullptr;
+	NodeListEntry *tail = nullptr;
+
+public:
+	SubscriberChain() = default;
+	SubscriberChain( const SubscriberChain & other ) = delete;
+	SubscriberChain & operator=( const SubscriberChain & other ) = delete;
+
+	// has to be called with locked subscribe mutex
+	NodeListEntry *acquire_free_entry() {
+		for( NodeListEntry *nle = head.load(); nle; nle = nle->next.load() ) {
+			if( !nle->in_use.load() ) {
+				nle->in_use.store( true );
+				return nle;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// has to be called with locked subscribe mutex
+	void append( NodeListEntry *nle ) {
+		nle->in_use = true;
+
+		if( tail ) {
+			tail->next.store( nle, std::memory_order_release );
+		} else {
+			head.store( nle, std::memory_order_release );
+		}
+
+		tail = nle;
+	}
+
+	/**
+	 * calls func() for every subscribed node,
+	 * has to be called inside of an epoch read section
+	 */
+	template<class Node, class Func>
+	void for_each_node( Func && func ) {
+		for_each_node_if<Node>( []( const NodeListEntry &, size_t ) { return true; },
+				[&func]( Node *node, NodeListEntry & ) { func( node ); } );
+	}
+
+	/**
+	 * calls func( node, entry ) for every subscribed node,
+	 * where filter( entry, index ) returns true.
+	 * has to be called inside of an epoch read section
+	 */
+	template<class Node, class Filter, class Func>
+	void for_each_node_if( Filter && filter, Func && func ) {
+		size_t index = 0;
+
+		for( NodeListEntry *nle = head.load( std::memory_order_acquire );
+			 nle;
+			 nle = nle->next.load( std::memory_order_acquire ), ++index ) {
+
+			void *node = nle->node.load( std::memory_order_acquire );
+
+			if( !node || !filter( *nle, index ) ) {
+				continue;
+			}
+
+			if( nle->operation_in_progress.exchange( true, std::memory_order_acquire ) ) {
+				nle->skipped.fetch_add( 1, std::memory_order_relaxed );
+				continue;
+			}
+
+			func( static_cast<Node*>(node), *nle );
+
+			nle->operation_in_progress.store( false, std::memory_order_release );
+		}
+	}
+};
+
+/**
+ * Nodes can subscribe and unsubscribe at any time, even while an other
+ * thread is inside distribute(). The entries are chained in a SubscriberChain,
+ * so the List is only a storage with stable addresses:
+ * std::list, or StaticNodeList<N> if no heap should be used.
+ *
+ * The publisher has to outlive its subscribers.
+ */
 template <class DataType, class Node=PublisherNode<DataType>, class List=std::list<NodeListEntry>>
 class Publisher
 {
 protected:
 	List nodes;
+	EpochDomain epoch;
+	std::mutex subscribe_mutex;
+	SubscriberChain chain;
 
 public:
 	Publisher() = default;
@@ -77,39 +634,433 @@ public:
 	Publisher & operator=( const Publisher & other ) = delete;
 
 	void subscribe( Node *node ) {
-		NodeListEntry & nle = nodes.emplace_back( node );
-		node->setRegistry( &nle );
+		std::lock_guard<std::mutex> lock( subscribe_mutex );
+		attach( chain, node );
 	}
 
 	void distribute( const DataType & data ) {
-		for( auto & nle : nodes ) {
-			bool op = nle.operation_in_progress;
+		EpochDomain::ReadGuard guard( epoch );
+		deliver( chain, data );
+	}
 
-			if( op ) {
-				continue;
+	/**
+	 * Distributes a whole batch with one walk through the subscribers.
+	 * If the node has a deliver( std::span<const DataType> ) function
+	 * it receives the batch at once, otherwise deliver() is called
+	 * for every element.
+	 */
+	void distribute( std::span<const DataType> data ) {
+		if( data.empty() ) {
+			return;
+		}
+
+		EpochDomain::ReadGuard guard( epoch );
+		deliver( chain, data );
+	}
+
+protected:
+
+	/**
+	 * has to be called with locked subscribe_mutex
+	 * throws std::logic_error if the node is already subscribed,
+	 * a node has only one registry entry.
+	 */
+	void attach( SubscriberChain & target, Node *node ) {
+		if( node->isSubscribed() ) {
+#if __cpp_exceptions > 0
+			throw std::logic_error("node is already subscribed");
+#else
+			std::abort();
+#endif
+		}
+
+		NodeListEntry *nle = target.acquire_free_entry();
+
+		if( !nle ) {
+			nle = &nodes.emplace_back( nullptr, &epoch );
+			target.append( nle );
+		}
+
+		node->setRegistry( nle );
+		nle->node.store( node, std::memory_order_release );
+	}
+
+	// has to be called inside of an epoch read section
+	static void deliver( SubscriberChain & target, const DataType & data ) {
+		target.for_each_node<Node>( [&data]( Node *node ) {
+			node->deliver( data );
+		});
+	}
+
+	static void deliver( SubscriberChain & target, std::span<const DataType> data ) {
+		target.for_each_node<Node>( [&data]( Node *node ) {
+			deliver( node, data );
+		});
+	}
+
+	static void deliver( Node *node, std::span<const DataType> data ) {
+		if constexpr( requires { node->deliver( data ); } ) {
+			node->deliver( data );
+		} else {
+			for( const DataType & d : data ) {
+				node->deliver( d );
 			}
+		}
+	}
+};
+
+/**
+ * A Publisher where the nodes are subscribing to a topic.
+ * The topic is evaluated at the publisher side through an index,
+ * so distribute() only touches the nodes that are interested in the topic,
+ * plus the nodes that have subscribed to all topics.
+ *
+ *   TopicPublisher<Quote,std::string,Node> publisher;
+ *   publisher.subscribe( &node, "EURUSD" );
+ *   publisher.subscribe_all( &logger );
+ *   publisher.distribute( quote.symbol, quote );
+ *
+ * A node can be subscribed to one topic, or to all of them. Subscribing
+ * it a second time throws std::logic_error, unsubscribe it first.
+ *
+ * The index is replaced copy on write when a node subscribes to a topic
+ * the first time, readers are never blocked by this. Topics without
+ * subscribers are kept, so the index grows with the number of distinct topics.
+ */
+template <class DataType,
+          class Topic,
+          class Node=PublisherNode<DataType>,
+          class List=std::list<NodeListEntry>,
+          class Hash=std::hash<Topic>>
+class TopicPublisher : public Publisher<DataType,Node,List>
+{
+	typedef Publisher<DataType,Node,List> base;
+	typedef std::unordered_map<Topic,SubscriberChain*,Hash> Index;
+
+protected:
+	std::list<SubscriberChain> topic_chains;
+	std::atomic<const Index*> index = nullptr;
+
+public:
+	TopicPublisher() = default;
+
+	~TopicPublisher() {
+		delete index.load();
+	}
+
+	// node receives the data of all topics
+	void subscribe_all( Node *node ) {
+		base::subscribe( node );
+	}
+
+	void subscribe( Node *node, const Topic & topic ) {
+		std::lock_guard<std::mutex> lock( base::subscribe_mutex );
+
+		const Index *current = index.load();
+		SubscriberChain *target = nullptr;
+
+		if( current ) {
+			auto it = current->find( topic );
+			if( it != current->end() ) {
+				target = it->second;
+			}
+		}
 
-			while(!nle.operation_in_progress.compare_exchange_weak( op, true ));
+		if( !target ) {
+			target = &topic_chains.emplace_back();
 
-			void *node = nle.node;
+			Index *next = current ? new Index( *current ) : new Index();
+			next->emplace( topic, target );
+			index.store( next );
 
-			if( node ) {
-				Node *n = (Node*)node;
-				n->deliver( data );
+			if( current ) {
+				// old index might be in use by distribute()
+				base::epoch.synchronize();
+				delete current;
 			}
+		}
+
+		base::attach( *target, node );
+	}
+
+	void distribute( const Topic & topic, const DataType & data ) {
+		EpochDomain::ReadGuard guard( base::epoch );
+
+		if( SubscriberChain *target = find( topic ) ) {
+			base::deliver( *target, data );
+		}
 
-			while(!nle.operation_in_progress.compare_exchange_weak( op, false ));
+		base::deliver( base::chain, data );
+	}
+
+	void distribute( const Topic & topic, std::span<const DataType> data ) {
+		if( data.empty() ) {
+			return;
+		}
+
+		EpochDomain::ReadGuard guard( base::epoch );
+
+		if( SubscriberChain *target = find( topic ) ) {
+			base::deliver( *target, data );
 		}
+
+		base::deliver( base::chain, data );
+	}
+
+protected:
+	// has to be called inside of an epoch read section
+	SubscriberChain *find( const Topic & topic ) const {
+		const Index *current = index.load( std::memory_order_acquire );
+
+		if( !current ) {
+			return nullptr;
+		}
+
+		auto it = current->find( topic );
+
+		if( it == current->end() ) {
+			return nullptr;
+		}
+
+		return it->second;
 	}
 };
 
+/**
+ * A Publisher that fans out the delivery over a set of worker threads.
+ * The subscribers are partitioned by their position in the chain, the
+ * publisher thread works on partition 0 itself, every worker on one of the
+ * others. distribute() returns when all partitions are done.
+ *
+ * Each deliver() call is measured. A node that misses the deadline
+ * slow_threshold times in a row is isolated: from then on it is served
+ * by a separate slow lane thread, through a queue of SlowQueueSize messages.
+ * So one misbehaving node does not raise the latency of the others.
+ * If the slow lane queue is full, the message is dropped for the isolated
+ * nodes and counted in getStatistics().
+ *
+ *   ParallelPublisher<Quote,Node>::Options options;
+ *   options.workers = 3;
+ *   options.deadline = std::chrono::microseconds(50);
+ *
+ *   ParallelPublisher<Quote,Node> publisher( options );
+ *
+ * distribute() may only be called by one thread at a time.
+ */
+template <class DataType,
+          class Node=PublisherNode<DataType>,
+          class List=std::list<NodeListEntry>,
+          size_t SlowQueueSize=1024>
+class ParallelPublisher : public Publisher<DataType,Node,List>
+{
+	typedef Publisher<DataType,Node,List> base;
+
+public:
+	struct Options
+	{
+		// worker threads additional to the publisher thread
+		size_t workers = 3;
+
+		// maximum duration of one deliver() call
+		std::chrono::nanoseconds deadline = std::chrono::microseconds(100);
+
+		// deadline misses in a row, until a node is isolated
+		unsigned slow_threshold = 3;
+	};
+
+	struct Statistics
+	{
+		size_t isolated_nodes = 0;	// nodes isolated so far
+		size_t slow_dropped = 0;	// messages the slow lane could not queue
+		size_t slow_depth = 0;		// currently queued in the slow lane
+	};
+
+protected:
+	const Options options;
+
+	std::vector<std::thread> workers;
+	std::thread slow_lane;
+
+	std::mutex distribute_mutex;
+	std::span<const DataType> job;
+
+	alignas(64) std::atomic<unsigned> generation = 0;
+	alignas(64) std::atomic<size_t> pending = 0;
+	alignas(64) std::atomic<unsigned> slow_signal = 0;
+	std::atomic<bool> stop = false;
+
+	std::atomic<size_t> isolated_nodes = 0;
+	std::atomic<size_t> slow_dropped = 0;
+
+	SpscMailbox<DataType,SlowQueueSize> slow_queue;
+
+public:
+	explicit ParallelPublisher( const Options & options_ = Options() )
+	: base(),
+	  options( options_ )
+	{
+		for( size_t i = 0; i < options.workers; ++i ) {
+			workers.emplace_back( [this,i]() { run_worker( i + 1 ); } );
+		}
+
+		slow_lane = std::thread( [this]() { run_slow_lane(); } );
+	}
+
+	~ParallelPublisher() {
+		stop = true;
+
+		generation.fetch_add( 1 );
+		generation.notify_all();
+
+		slow_signal.fetch_add( 1 );
+		slow_signal.notify_all();
+
+		for( auto & worker : workers ) {
+			worker.join();
+		}
+
+		slow_lane.join();
+	}
+
+	void distribute( const DataType & data ) {
+		distribute( std::span<const DataType>( &data, 1 ) );
+	}
+
+	void distribute( std::span<const DataType> data ) {
+		if( data.empty() ) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock( distribute_mutex );
+		EpochDomain::ReadGuard guard( base::epoch );
+
+		job = data;
+
+		if( !workers.empty() ) {
+			pending.store( workers.size() );
+			generation.fetch_add( 1 );
+			generation.notify_all();
+		}
+
+		deliver_partition( 0 );
+
+		if( isolated_nodes.load( std::memory_order_relaxed ) > 0 ) {
+			for( const DataType & d : data ) {
+				if( !slow_queue.push( d ) ) {
+					slow_dropped.fetch_add( 1, std::memory_order_relaxed );
+				}
+			}
+
+			slow_signal.fetch_add( 1 );
+			slow_signal.notify_one();
+		}
+
+		for( size_t p = pending.load(); p != 0; p = pending.load() ) {
+			pending.wait( p );
+		}
+	}
+
+	Statistics getStatistics() const {
+		Statistics stat;
+		stat.isolated_nodes = isolated_nodes.load( std::memory_order_relaxed );
+		stat.slow_dropped = slow_dropped.load( std::memory_order_relaxed );
+		stat.slow_depth = slow_queue.size();
+		return stat;
+	}
+
+protected:
+
+	void deliver_partition( size_t partition ) {
+		const size_t partitions = workers.size() + 1;
+		const std::span<const DataType> data = job;
+
+		base::chain.template for_each_node_if<Node>(
+				[partition, partitions]( const NodeListEntry & nle, size_t index ) {
+					return index % partitions == partition && !nle.isolated.load( std::memory_order_relaxed );
+				},
+				[this, &data]( Node *node, NodeListEntry & nle ) {
+					const auto start = std::chrono::steady_clock::now();
+
+					base::deliver( node, data );
+
+					if( std::chrono::steady_clock::now() - start <= options.deadline * data.size() ) {
+						nle.deadline_misses.store( 0, std::memory_order_relaxed );
+						return;
+					}
+
+					const unsigned misses = nle.deadline_misses.load( std::memory_order_relaxed ) + 1;
+					nle.deadline_misses.store( misses, std::memory_order_relaxed );
+
+					if( misses >= options.slow_threshold ) {
+						isolate( nle );
+					}
+				});
+	}
+
+	void isolate( NodeListEntry & nle ) {
+		if( !nle.isolated.exchange( true ) ) {
+			isolated_nodes.fetch_add( 1 );
+		}
+	}
+
+	void run_worker( size_t partition ) {
+		// the workers are started before the first distribute() call
+		unsigned seen = 0;
+
+		while( true ) {
+			generation.wait( seen );
+			seen = generation.load();
+
+			if( stop ) {
+				return;
+			}
+
+			deliver_partition( partition );
+
+			if( pending.fetch_sub( 1 ) == 1 ) {
+				pending.notify_one();
+			}
+		}
+	}
+
+	void run_slow_lane() {
+		unsigned seen = slow_signal.load();
+		DataType data;
+
+		while( true ) {
+			while( slow_queue.pop( data ) ) {
+				EpochDomain::ReadGuard guard( base::epoch );
+
+				base::chain.template for_each_node_if<Node>(
+						[]( const NodeListEntry & nle, size_t ) {
+							return nle.isolated.load( std::memory_order_relaxed );
+						},
+						[&data]( Node *node, NodeListEntry & ) {
+							node->deliver( data );
+						});
+			}
+
+			if( stop ) {
+				return;
+			}
+
+			slow_signal.wait( seen );
+			seen = slow_signal.load();
+		}
+	}
+};
+
+/**
+ * Heap free storage for the Publisher. Can hold at most N entries,
+ * the entries never move.
+ */
 template <size_t N>
 class StaticNodeList {
 public:
-	typedef typename std::array<NodeListEntry, N>::value_type value_type;
-	typedef typename std::array<NodeListEntry, N>::reference reference;
-	typedef typename std::array<NodeListEntry, N>::const_reference const_reference;
-	typedef typename std::array<NodeListEntry, N>::size_type size_type;
+	typedef NodeListEntry value_type;
+	typedef NodeListEntry & reference;
+	typedef const NodeListEntry & const_reference;
+	typedef size_t size_type;
 
 	static constexpr size_t npos = N;
 
@@ -154,76 +1105,78 @@ public:
 
 public:
 
+	StaticNodeList() = default;
+	StaticNodeList( const StaticNodeList & other ) = delete;
+	StaticNodeList & operator=( const StaticNodeList & other ) = delete;
+
 	~StaticNodeList() {
-		while (size()) {
-			pop_front();
-		}
+		clear();
 	}
 
-	void push_back(const NodeListEntry& v) {
+	/**
+	 * throws std::out_of_range exception if the capacity is reached
+	 */
+	template< class... Args >
+	reference emplace_back( Args&&... args ) {
 		if (size_ + 1 > N) {
-			throw;
+#if __cpp_exceptions > 0
+			throw std::out_of_range("max size reached");
+#else
+			std::abort();
+#endif
 		}
-		new (&array_[(front_ + size_) % N]) NodeListEntry(v);
-		++size_;
-	}
 
-	void push_back(const NodeListEntry& v, bool discard_front ) {
-		if (size_ + 1 > N) {
-			pop_front();
-		}
-		new (&array_[(front_ + size_) % N]) NodeListEntry(v);
+		NodeListEntry *nle = new (&array_[size_ * sizeof(NodeListEntry)]) NodeListEntry( std::forward<Args>(args)... );
 		++size_;
+		return *nle;
 	}
 
-	void pop_front() {
-		if (size_ < 1) {
-			throw;
+	void clear() {
+		while( size_ > 0 ) {
+			(*this)[--size_].~NodeListEntry();
 		}
-
-		front().~NodeListEntry();
-		++front_;
-		--size_;
-		if (front_ >= N)
-			front_ = 0;
 	}
 
 	const_reference front() const {
-		return array_[front_];
+		return (*this)[0];
 	}
 
 	reference front() {
-		return array_[front_];
+		return (*this)[0];
 	}
 
 	size_type size() const {
 		return size_;
 	}
 
+	constexpr size_type capacity() const {
+		return N;
+	}
+
 	bool empty() const {
 		return (size() == 0);
 	}
 
 	const_reference operator[]( size_t n ) const {
-		return array_[(front_+n)%N];
+		return *std::launder( reinterpret_cast<const NodeListEntry*>( &array_[n * sizeof(NodeListEntry)] ) );
 	}
 
 	reference operator[]( size_t n ) {
-		return array_[(front_+n)%N];
+		return *std::launder( reinterpret_cast<NodeListEntry*>( &array_[n * sizeof(NodeListEntry)] ) );
 	}
 
 	reference at( size_t pos ) {
 		if (pos >= size()) {
 			throw std::out_of_range("out of range");
 		}
-		return array_[(front_+pos)%N];
+		return (*this)[pos];
 	}
 
 	const_reference at( size_t pos ) const {
 		if (pos >= size()) {
 			throw std::out_of_range("out of range");
 		}
-		return array_[(front_+pos)%N];
+		return (*this)[pos];
 	}
 
 	iterator begin() {
@@ -235,9 +1188,8 @@ public:
 	}
 
 private:
-	size_type front_ = 0;
 	size_type size_ = 0;
-	std::array<NodeListEntry, N> array_;
+	alignas(NodeListEntry) std::byte array_[sizeof(NodeListEntry) * N];
 };
 
 } // namespace FastDelivery
@@ -0,0 +1,458 @@
+/**
+ * FastDelivery between processes on the same host
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * The data is written into a ring buffer in shared memory (shm_open or memfd,
+ * plus mmap). Waiting readers are woken up through a futex in the ring.
+ * No sockets, no serialization, DataType has to be trivially copyable.
+ *
+ * Sending process:
+ *
+ *   Publisher<Quote,ShmPublisherNode<Quote>> publisher;
+ *   ShmPublisherNode<Quote> shm( "/quotes" );
+ *   publisher.subscribe( &shm );
+ *   publisher.distribute( quote );
+ *
+ * Receiving process:
+ *
+ *   ShmPublisher<Quote,Node> publisher( "/quotes" );
+ *   publisher.subscribe( &node );
+ *
+ *   while( true ) {
+ *     publisher.receive( std::chrono::milliseconds(100) );  // calls node.deliver()
+ *   }
+ *
+ * There is one writer per ring. Every reader has its own read position.
+ * A reader that falls behind more than the ring size loses the oldest
+ * messages, they are counted in getLost().
+ */
+#pragma once
+#ifndef FASTDELIVERY_SHM_H_
+#define FASTDELIVERY_SHM_H_
+
+#include "FastDelivery.h"
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+namespace Tools {
+namespace FastDelivery {
+
+namespace detail {
+
+inline void futex_wake( std::atomic<uint32_t> *addr )
+{
+	syscall( SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0 );
+}
+
+// returns false on timeout
+inline bool futex_wait( std::atomic<uint32_t> *addr, uint32_t expected, std::chrono::nanoseconds timeout )
+{
+	struct timespec ts;
+	ts.tv_sec = timeout.count() / 1000000000;
+	ts.tv_nsec = timeout.count() % 1000000000;
+
+	if( syscall( SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, &ts, nullptr, 0 ) != 0 ) {
+		return errno != ETIMEDOUT;
+	}
+
+	return true;
+}
+
+[[noreturn]] inline void throw_errno( const std::string & what )
+{
+#if __cpp_exceptions > 0
+	throw std::system_error( errno, std::generic_category(), what );
+#else
+	std::abort();
+#endif
+}
+
+/**
+ * The mapped ring buffer. The layout in shared memory is:
+ *
+ *   Header | Slot 0 | Slot 1 | ... | Slot slot_count-1
+ *
+ * Every slot is protected by a sequence number (seqlock):
+ * odd while the writer is copying, 2 * (message number + 1) when done.
+ */
+template <class DataType>
+class ShmRing
+{
+	static_assert( std::is_trivially_copyable<DataType>::value, "DataType has to be trivially copyable" );
+	static_assert( std::atomic<uint64_t>::is_always_lock_free, "64 bit atomics have to be lock free" );
+	static_assert( std::atomic<uint32_t>::is_always_lock_free, "32 bit atomics have to be lock free" );
+
+public:
+	static constexpr uint32_t MAGIC = 0x46445348; // FDSH
+	static constexpr uint32_t VERSION = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t slot_size;
+		uint64_t slot_count;
+
+		// number of published messages
+		alignas(64) std::atomic<uint64_t> write_seq;
+
+		// incremented on every publish, the readers are waiting on it
+		alignas(64) std::atomic<uint32_t> futex;
+		std::atomic<uint32_t> waiters;
+	};
+
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> seq;
+		DataType data;
+	};
+
+protected:
+	int fd = -1;
+	void *mapping = MAP_FAILED;
+	size_t mapping_size = 0;
+	Header *header = nullptr;
+	Slot *slots = nullptr;
+
+public:
+	ShmRing() = default;
+	ShmRing( const ShmRing & other ) = delete;
+	ShmRing & operator=( const ShmRing & other ) = delete;
+
+	~ShmRing() {
+		if( mapping != MAP_FAILED ) {
+			munmap( mapping, mapping_size );
+		}
+
+		if( fd >= 0 ) {
+			close( fd );
+		}
+	}
+
+	static size_t required_size( size_t slot_count ) {
+		return sizeof(Header) + sizeof(Slot) * slot_count;
+	}
+
+	// creates a new ring, or resets an existing one with the same name
+	void create( const std::string & name, size_t slot_count ) {
+		fd = shm_open( name.c_str(), O_CREAT | O_RDWR, 0600 );
+
+		if( fd < 0 ) {
+			throw_errno( "shm_open " + name );
+		}
+
+		init( slot_count );
+	}
+
+	// creates an anonymous ring, the fd can be passed to other processes
+	void create_memfd( const std::string & name, size_t slot_count ) {
+		fd = static_cast<int>( syscall( SYS_memfd_create, name.c_str(), 0 ) );
+
+		if( fd < 0 ) {
+			throw_errno( "memfd_create " + name );
+		}
+
+		init( slot_count );
+	}
+
+	void open( const std::string & name ) {
+		fd = shm_open( name.c_str(), O_RDWR, 0600 );
+
+		if( fd < 0 ) {
+			throw_errno( "shm_open " + name );
+		}
+
+		attach();
+	}
+
+	// takes the ownership of the fd
+	void open_fd( int fd_ ) {
+		fd = fd_;
+		attach();
+	}
+
+	static void unlink( const std::string & name ) {
+		shm_unlink( name.c_str() );
+	}
+
+	int get_fd() const {
+		return fd;
+	}
+
+	Header *get_header() {
+		return header;
+	}
+
+	uint64_t get_slot_count() const {
+		return header->slot_count;
+	}
+
+	// only one writer per ring
+	void write( const DataType & data ) {
+		const uint64_t n = header->write_seq.load( std::memory_order_relaxed );
+		Slot & slot = slots[n % header->slot_count];
+
+		slot.seq.store( 2 * n + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+
+		std::memcpy( static_cast<void*>(&slot.data), &data, sizeof(DataType) );
+
+		slot.seq.store( 2 * n + 2, std::memory_order_release );
+		header->write_seq.store( n + 1, std::memory_order_release );
+
+		header->futex.fetch_add( 1, std::memory_order_release );
+
+		if( header->waiters.load() > 0 ) {
+			futex_wake( &header->futex );
+		}
+	}
+
+	/**
+	 * reads message number n
+	 * returns false if it was overwritten meanwhile
+	 */
+	bool read( uint64_t n, DataType & data ) {
+		Slot & slot = slots[n % header->slot_count];
+
+		if( slot.seq.load( std::memory_order_acquire ) != 2 * n + 2 ) {
+			return false;
+		}
+
+		std::memcpy( &data, static_cast<const void*>(&slot.data), sizeof(DataType) );
+		std::atomic_thread_fence( std::memory_order_acquire );
+
+		return slot.seq.load( std::memory_order_relaxed ) == 2 * n + 2;
+	}
+
+	// returns false on timeout
+	bool wait( uint64_t n, std::chrono::nanoseconds timeout ) {
+		const uint32_t f = header->futex.load( std::memory_order_acquire );
+
+		if( header->write_seq.load( std::memory_order_acquire ) != n ) {
+			return true;
+		}
+
+		header->waiters.fetch_add( 1 );
+		bool res = futex_wait( &header->futex, f, timeout );
+		header->waiters.fetch_sub( 1 );
+
+		return res && header->write_seq.load( std::memory_order_acquire ) != n;
+	}
+
+protected:
+	void init( size_t slot_count ) {
+		if( slot_count == 0 ) {
+#if __cpp_exceptions > 0
+			throw std::out_of_range( "slot_count has to be at least 1" );
+#else
+			std::abort();
+#endif
+		}
+
+		if( ftruncate( fd, required_size( slot_count ) ) != 0 ) {
+			throw_errno( "ftruncate" );
+		}
+
+		map( required_size( slot_count ) );
+
+		std::memset( mapping, 0, mapping_size );
+
+		header = new (mapping) Header();
+		header->slot_size = sizeof(Slot);
+		header->slot_count = slot_count;
+		header->write_seq = 0;
+		header->futex = 0;
+		header->waiters = 0;
+
+		slots = reinterpret_cast<Slot*>( static_cast<char*>(mapping) + sizeof(Header) );
+
+		for( size_t i = 0; i < slot_count; ++i ) {
+			new (&slots[i]) Slot();
+			slots[i].seq = 0;
+		}
+
+		header->version = VERSION;
+		std::atomic_thread_fence( std::memory_order_release );
+		header->magic = MAGIC;
+	}
+
+	void attach() {
+		struct stat st;
+
+		if( fstat( fd, &st ) != 0 ) {
+			throw_errno( "fstat" );
+		}
+
+		if( static_cast<size_t>(st.st_size) < sizeof(Header) ) {
+			errno = EINVAL;
+			throw_errno( "shared memory too small" );
+		}
+
+		map( st.st_size );
+
+		header = static_cast<Header*>( mapping );
+
+		if( header->magic != MAGIC ||
+			header->version != VERSION ||
+			header->slot_size != sizeof(Slot) ||
+			required_size( header->slot_count ) > mapping_size ) {
+			errno = EINVAL;
+			throw_errno( "shared memory layout does not match the DataType" );
+		}
+
+		slots = reinterpret_cast<Slot*>( static_cast<char*>(mapping) + sizeof(Header) );
+	}
+
+	void map( size_t size ) {
+		mapping_size = size;
+		mapping = mmap( nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+		if( mapping == MAP_FAILED ) {
+			throw_errno( "mmap" );
+		}
+	}
+};
+
+} // namespace detail
+
+/**
+ * Writes everything it gets delivered into the shared memory ring.
+ */
+template <class DataType>
+class ShmPublisherNode : public PublisherNode<DataType>
+{
+protected:
+	detail::ShmRing<DataType> ring;
+
+public:
+	/**
+	 * creates the ring with the name, use a leading '/'
+	 */
+	ShmPublisherNode( const std::string & name, size_t slot_count = 1024 ) {
+		ring.create( name, slot_count );
+	}
+
+	/**
+	 * creates an anonymous ring with memfd_create(),
+	 * pass getFd() to the other processes (fork, or SCM_RIGHTS)
+	 */
+	struct Anonymous {};
+
+	ShmPublisherNode( Anonymous, const std::string & name, size_t slot_count = 1024 ) {
+		ring.create_memfd( name, slot_count );
+	}
+
+	~ShmPublisherNode() {
+		PublisherNode<DataType>::unsubscribe();
+	}
+
+	void deliver( const DataType & data ) {
+		ring.write( data );
+	}
+
+	int getFd() const {
+		return ring.get_fd();
+	}
+
+	static void unlink( const std::string & name ) {
+		detail::ShmRing<DataType>::unlink( name );
+	}
+};
+
+/**
+ * A Publisher that is fed by a shared memory ring, written
+ * by a ShmPublisherNode in an other process. receive() distributes
+ * the new messages to the local subscribers.
+ */
+template <class DataType, class Node=PublisherNode<DataType>, class List=std::list<NodeListEntry>>
+class ShmPublisher : public Publisher<DataType,Node,List>
+{
+	typedef Publisher<DataType,Node,List> base;
+
+protected:
+	detail::ShmRing<DataType> ring;
+	uint64_t read_seq = 0;
+	size_t lost = 0;
+
+public:
+	// only messages that are published after opening are received
+	explicit ShmPublisher( const std::string & name ) {
+		ring.open( name );
+		read_seq = ring.get_header()->write_seq.load( std::memory_order_acquire );
+	}
+
+	// takes the ownership of the fd
+	explicit ShmPublisher( int fd ) {
+		ring.open_fd( fd );
+		read_seq = ring.get_header()->write_seq.load( std::memory_order_acquire );
+	}
+
+	/**
+	 * Waits up to timeout for new messages and distributes them.
+	 * returns the number of distributed messages
+	 */
+	size_t receive( std::chrono::nanoseconds timeout ) {
+		size_t count = poll();
+
+		if( count > 0 ) {
+			return count;
+		}
+
+		if( !ring.wait( read_seq, timeout ) ) {
+			return 0;
+		}
+
+		return poll();
+	}
+
+	/**
+	 * distributes the messages that are available, without waiting
+	 * returns the number of distributed messages
+	 */
+	size_t poll() {
+		const uint64_t write_seq = ring.get_header()->write_seq.load( std::memory_order_acquire );
+		const uint64_t slot_count = ring.get_slot_count();
+		size_t count = 0;
+		DataType data;
+
+		for( ; read_seq < write_seq; ++read_seq ) {
+			// the writer is a whole round ahead
+			if( write_seq - read_seq > slot_count ) {
+				lost += write_seq - slot_count - read_seq;
+				read_seq = write_seq - slot_count;
+			}
+
+			if( !ring.read( read_seq, data ) ) {
+				lost++;
+				continue;
+			}
+
+			base::distribute( data );
+			count++;
+		}
+
+		return count;
+	}
+
+	// messages that were overwritten before they could be read
+	size_t getLost() const {
+		return lost;
+	}
+};
+
+} // namespace FastDelivery
+} // namespace Tools
+
+#endif /* FASTDELIVERY_SHM_H_ */
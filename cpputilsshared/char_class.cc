@@ -0,0 +1,210 @@
+/**
+ * SIMD variants of the character class matcher
+ * @author Copyright (c) 2026 Martin Oberzalek
+ */
+
+#include "char_class.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define TOOLS_CHAR_CLASS_X86
+#  include <immintrin.h>
+#endif
+
+namespace Tools {
+
+#ifdef TOOLS_CHAR_CLASS_X86
+
+namespace {
+
+enum class SimdLevel
+{
+	NONE,
+	SSSE3,
+	AVX2
+};
+
+SimdLevel simd_level()
+{
+	static const SimdLevel level = []() {
+		__builtin_cpu_init();
+
+		if( __builtin_cpu_supports( "avx2" ) ) {
+			return SimdLevel::AVX2;
+		}
+
+		if( __builtin_cpu_supports( "ssse3" ) ) {
+			return SimdLevel::SSSE3;
+		}
+
+		return SimdLevel::NONE;
+	}();
+
+	return level;
+}
+
+/*
+ * Nibble lookup (Wojciech Mula): the low nibble selects a byte in the
+ * table of the lower or the upper half of the character range,
+ * the high nibble selects a bit in this byte. pshufb returns 0,
+ * if bit 7 of the index is set, which picks the right table.
+ */
+__attribute__((target("ssse3")))
+size_t find_chars_ssse3( const uint8_t *nibbles_low, const uint8_t *nibbles_high,
+						 const char *s, size_t len, size_t pos, bool match )
+{
+	const __m128i tlow  = _mm_loadu_si128( reinterpret_cast<const __m128i*>( nibbles_low ) );
+	const __m128i thigh = _mm_loadu_si128( reinterpret_cast<const __m128i*>( nibbles_high ) );
+	const __m128i bitsel = _mm_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+	const __m128i index_mask = _mm_set1_epi8( static_cast<char>( 0x8f ) );
+	const __m128i high_bit = _mm_set1_epi8( static_cast<char>( 0x80 ) );
+	const __m128i nibble_mask = _mm_set1_epi8( 0x0f );
+
+	for( ; pos + 16 <= len; pos += 16 ) {
+		const __m128i x = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s + pos ) );
+		const __m128i index = _mm_and_si128( x, index_mask );
+		const __m128i row = _mm_or_si128( _mm_shuffle_epi8( tlow, index ),
+										  _mm_shuffle_epi8( thigh, _mm_xor_si128( index, high_bit ) ) );
+		const __m128i bit = _mm_shuffle_epi8( bitsel, _mm_and_si128( _mm_srli_epi16( x, 4 ), nibble_mask ) );
+		const __m128i found = _mm_cmpeq_epi8( _mm_and_si128( row, bit ), bit );
+
+		unsigned mask = static_cast<unsigned>( _mm_movemask_epi8( found ) );
+
+		if( !match ) {
+			mask = ~mask & 0xffff;
+		}
+
+		if( mask ) {
+			return pos + __builtin_ctz( mask );
+		}
+	}
+
+	return pos;
+}
+
+__attribute__((target("avx2")))
+size_t find_chars_avx2( const uint8_t *nibbles_low, const uint8_t *nibbles_high,
+						const char *s, size_t len, size_t pos, bool match )
+{
+	// pshufb works per 128 bit lane, so both lanes get the same table
+	const __m256i tlow  = _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>( nibbles_low ) ) );
+	const __m256i thigh = _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>( nibbles_high ) ) );
+	const __m256i bitsel = _mm256_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+											 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+	const __m256i index_mask = _mm256_set1_epi8( static_cast<char>( 0x8f ) );
+	const __m256i high_bit = _mm256_set1_epi8( static_cast<char>( 0x80 ) );
+	const __m256i nibble_mask = _mm256_set1_epi8( 0x0f );
+
+	for( ; pos + 32 <= len; pos += 32 ) {
+		const __m256i x = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s + pos ) );
+		const __m256i index = _mm256_and_si256( x, index_mask );
+		const __m256i row = _mm256_or_si256( _mm256_shuffle_epi8( tlow, index ),
+											 _mm256_shuffle_epi8( thigh, _mm256_xor_si256( index, high_bit ) ) );
+		const __m256i bit = _mm256_shuffle_epi8( bitsel, _mm256_and_si256( _mm256_srli_epi16( x, 4 ), nibble_mask ) );
+		const __m256i found = _mm256_cmpeq_epi8( _mm256_and_si256( row, bit ), bit );
+
+		unsigned mask = static_cast<unsigned>( _mm256_movemask_epi8( found ) );
+
+		if( !match ) {
+			mask = ~mask;
+		}
+
+		if( mask ) {
+			return pos + __builtin_ctz( mask );
+		}
+	}
+
+	return pos;
+}
+
+// compares 8 wide characters with every character of the set
+__attribute__((target("avx2")))
+size_t find_wchars_avx2( const uint32_t *chars, unsigned chars_count,
+						 const uint32_t *s, size_t len, size_t pos, bool match )
+{
+	__m256i set[basic_char_class<wchar_t>::MAX_SIMD_CHARS];
+
+	for( unsigned i = 0; i < chars_count; ++i ) {
+		set[i] = _mm256_set1_epi32( static_cast<int>( chars[i] ) );
+	}
+
+	for( ; pos + 8 <= len; pos += 8 ) {
+		const __m256i x = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s + pos ) );
+		__m256i found = _mm256_cmpeq_epi32( x, set[0] );
+
+		for( unsigned i = 1; i < chars_count; ++i ) {
+			found = _mm256_or_si256( found, _mm256_cmpeq_epi32( x, set[i] ) );
+		}
+
+		unsigned mask = static_cast<unsigned>( _mm256_movemask_ps( _mm256_castsi256_ps( found ) ) );
+
+		if( !match ) {
+			mask = ~mask & 0xff;
+		}
+
+		if( mask ) {
+			return pos + __builtin_ctz( mask );
+		}
+	}
+
+	return pos;
+}
+
+} // namespace
+
+template <>
+size_t basic_char_class<char>::find_simd( const char *s, size_t len, size_t pos, bool match ) const
+{
+	switch( simd_level() ) {
+	case SimdLevel::AVX2:
+		pos = find_chars_avx2( nibbles_low, nibbles_high, s, len, pos, match );
+
+		if( pos + 32 <= len ) {
+			return pos;
+		}
+
+		// the rest as one SSSE3 block
+		return find_chars_ssse3( nibbles_low, nibbles_high, s, len, pos, match );
+
+	case SimdLevel::SSSE3:
+		return find_chars_ssse3( nibbles_low, nibbles_high, s, len, pos, match );
+
+	case SimdLevel::NONE:
+		break;
+	}
+
+	return pos;
+}
+
+template <>
+size_t basic_char_class<wchar_t>::find_simd( const wchar_t *s, size_t len, size_t pos, bool match ) const
+{
+	if( sizeof(wchar_t) != sizeof(uint32_t) || chars_count == 0 || simd_level() != SimdLevel::AVX2 ) {
+		return pos;
+	}
+
+	uint32_t set[MAX_SIMD_CHARS];
+
+	for( unsigned i = 0; i < chars_count; ++i ) {
+		set[i] = static_cast<uint32_t>( chars[i] );
+	}
+
+	return find_wchars_avx2( set, chars_count, reinterpret_cast<const uint32_t*>( s ), len, pos, match );
+}
+
+#else
+
+template <>
+size_t basic_char_class<char>::find_simd( const char *, size_t, size_t pos, bool ) const
+{
+	return pos;
+}
+
+template <>
+size_t basic_char_class<wchar_t>::find_simd( const wchar_t *, size_t, size_t pos, bool ) const
+{
+	return pos;
+}
+
+#endif
+
+} // namespace Tools
@@ -0,0 +1,223 @@
+/**
+ * Character class matcher for the split and strip functions
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::basic_char_class<char> separators( " \t\n", 3 );
+ *    size_t pos = separators.find_first_of( line.data(), line.size() );
+ *
+ *    // or directly on strings
+ *    auto pos = Tools::detail::find_first_of_class( line, std::string(" \t\n") );
+ *
+ * The set is converted into a 256 bit lookup table once. Searching is
+ * O(n) then, instead of comparing every character with every separator.
+ *
+ * On x86 processors with AVX2 or SSSE3 (detected at runtime) 32 or 16
+ * characters are classified at once. For char it uses the pshufb nibble
+ * lookup, so the size of the set does not matter. For 4 byte wchar_t the
+ * characters are compared with up to 8 separators.
+ * Everywhere else the lookup table is used.
+ */
+#ifndef TOOLS_CHAR_CLASS_H
+#define TOOLS_CHAR_CLASS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace Tools {
+
+template <class CharT>
+class basic_char_class
+{
+public:
+	static const size_t npos = static_cast<size_t>(-1);
+
+	// the maximum number of characters for the wchar_t SIMD compare
+	static const unsigned MAX_SIMD_CHARS = 8;
+
+private:
+	// characters < 256
+	uint64_t bits[4];
+
+	// pshufb tables: for each low nibble the high nibbles 0-7 and 8-15
+	uint8_t nibbles_low[16];
+	uint8_t nibbles_high[16];
+
+	// the set itself, if it is small enough
+	CharT chars[MAX_SIMD_CHARS];
+	unsigned chars_count;
+
+	// characters >= 256, only wide characters
+	std::basic_string<CharT> others;
+
+	static unsigned uchar( CharT c ) {
+		return static_cast<unsigned>( static_cast<typename std::make_unsigned<CharT>::type>( c ) );
+	}
+
+public:
+	basic_char_class( const CharT *set, size_t len );
+
+	explicit basic_char_class( const std::basic_string<CharT> & set )
+	: basic_char_class( set.data(), set.size() )
+	{}
+
+	bool contains( CharT c ) const {
+		const unsigned u = uchar( c );
+
+		if( u < 256 ) {
+			return (bits[u >> 6] >> (u & 63)) & 1;
+		}
+
+		return !others.empty() && others.find( c ) != std::basic_string<CharT>::npos;
+	}
+
+	size_t find_first_of( const CharT *s, size_t len, size_t pos = 0 ) const {
+		return find_first( s, len, pos, true );
+	}
+
+	size_t find_first_not_of( const CharT *s, size_t len, size_t pos = 0 ) const {
+		return find_first( s, len, pos, false );
+	}
+
+	size_t find_last_of( const CharT *s, size_t len, size_t pos = npos ) const {
+		return find_last( s, len, pos, true );
+	}
+
+	size_t find_last_not_of( const CharT *s, size_t len, size_t pos = npos ) const {
+		return find_last( s, len, pos, false );
+	}
+
+private:
+	// the first position >= pos, where contains() == match
+	size_t find_first( const CharT *s, size_t len, size_t pos, bool match ) const {
+		if( pos >= len ) {
+			return npos;
+		}
+
+		// the SIMD variants are handling the full blocks only
+		pos = find_simd( s, len, pos, match );
+
+		for( ; pos < len; ++pos ) {
+			if( contains( s[pos] ) == match ) {
+				return pos;
+			}
+		}
+
+		return npos;
+	}
+
+	size_t find_last( const CharT *s, size_t len, size_t pos, bool match ) const {
+		if( len == 0 ) {
+			return npos;
+		}
+
+		if( pos >= len ) {
+			pos = len - 1;
+		}
+
+		// strip() is only looking at a few trailing characters, so no SIMD here
+		for( ; ; --pos ) {
+			if( contains( s[pos] ) == match ) {
+				return pos;
+			}
+
+			if( pos == 0 ) {
+				return npos;
+			}
+		}
+	}
+
+	/**
+	 * Returns the first position where contains() == match,
+	 * or the start of the remaining characters, that were
+	 * not checked.
+	 */
+	size_t find_simd( const CharT *s, size_t len, size_t pos, bool match ) const;
+};
+
+template <class CharT>
+inline basic_char_class<CharT>::basic_char_class( const CharT *set, size_t len )
+: bits(),
+  nibbles_low(),
+  nibbles_high(),
+  chars(),
+  chars_count( len <= MAX_SIMD_CHARS ? static_cast<unsigned>(len) : 0 )
+{
+	for( size_t i = 0; i < len; ++i ) {
+		const unsigned u = uchar( set[i] );
+
+		if( i < chars_count ) {
+			chars[i] = set[i];
+		}
+
+		if( u >= 256 ) {
+			others += set[i];
+			continue;
+		}
+
+		bits[u >> 6] |= uint64_t(1) << (u & 63);
+
+		if( u < 128 ) {
+			nibbles_low[u & 15] |= static_cast<uint8_t>( 1 << (u >> 4) );
+		} else {
+			nibbles_high[u & 15] |= static_cast<uint8_t>( 1 << ((u >> 4) - 8) );
+		}
+	}
+}
+
+// only char and wchar_t have SIMD variants
+template <class CharT>
+inline size_t basic_char_class<CharT>::find_simd( const CharT *, size_t, size_t pos, bool ) const
+{
+	return pos;
+}
+
+template <> size_t basic_char_class<char>::find_simd( const char *s, size_t len, size_t pos, bool match ) const;
+template <> size_t basic_char_class<wchar_t>::find_simd( const wchar_t *s, size_t len, size_t pos, bool match ) const;
+
+typedef basic_char_class<char>    char_class;
+typedef basic_char_class<wchar_t> wchar_class;
+
+namespace detail {
+
+/**
+ * find_first_of() and friends for all string types, that are
+ * providing data() and size(), like std::string and std::string_view
+ */
+template <class t_std_string, class t_std_string_set>
+inline typename t_std_string::size_type find_first_of_class( const t_std_string & s,
+															 const t_std_string_set & set,
+															 typename t_std_string::size_type pos = 0 )
+{
+	basic_char_class<typename t_std_string::value_type> cc( set.data(), set.size() );
+	size_t res = cc.find_first_of( s.data(), s.size(), pos );
+	return res == cc.npos ? t_std_string::npos : res;
+}
+
+template <class t_std_string, class t_std_string_set>
+inline typename t_std_string::size_type find_first_not_of_class( const t_std_string & s,
+																 const t_std_string_set & set,
+																 typename t_std_string::size_type pos = 0 )
+{
+	basic_char_class<typename t_std_string::value_type> cc( set.data(), set.size() );
+	size_t res = cc.find_first_not_of( s.data(), s.size(), pos );
+	return res == cc.npos ? t_std_string::npos : res;
+}
+
+template <class t_std_string, class t_std_string_set>
+inline typename t_std_string::size_type find_last_not_of_class( const t_std_string & s,
+																const t_std_string_set & set,
+																typename t_std_string::size_type pos = t_std_string::npos )
+{
+	basic_char_class<typename t_std_string::value_type> cc( set.data(), set.size() );
+	size_t res = cc.find_last_not_of( s.data(), s.size(), pos );
+	return res == cc.npos ? t_std_string::npos : res;
+}
+
+} // namespace detail
+
+} // namespace Tools
+
+#endif
@@ -0,0 +1,262 @@
+/**
+ * Lazy split functions, that are returning std::string_view tokens
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    for( std::string_view token : Tools::split_view( line, " \t" ) ) {
+ *       if( token == "END" ) {
+ *          break;
+ *       }
+ *       ...
+ *    }
+ *
+ *    for( auto field : Tools::split_string_view_lazy( line, "||", 3 ) ) {
+ *       ...
+ *    }
+ *
+ * The tokens are the same as the ones of split_simple(),
+ * split_and_strip_simple() and split_string(), but they are
+ * found one after the other, while iterating. Nothing is copied
+ * and nothing is allocated.
+ *
+ * The view and its tokens are pointing into the original string,
+ * so the string has to live longer than them.
+ */
+#ifndef TOOLS_SPLIT_VIEW_H
+#define TOOLS_SPLIT_VIEW_H
+
+#include "char_class.h"
+#include <string_view>
+#include <iterator>
+#include <cstddef>
+
+namespace Tools {
+
+template <class CharT>
+class basic_split_view
+{
+public:
+	typedef std::basic_string_view<CharT> string_view_type;
+	typedef typename string_view_type::size_type size_type;
+
+	enum class Mode
+	{
+		SIMPLE,   // like split_simple()
+		STRIP,    // like split_and_strip_simple()
+		STRING    // like split_string()
+	};
+
+private:
+	string_view_type str;
+	string_view_type sep;
+	int max;
+	Mode mode;
+	basic_char_class<CharT> sep_class;
+
+public:
+	class iterator
+	{
+		const basic_split_view *view = nullptr;
+		string_view_type token;
+
+		// start of the remaining string, npos: token is the last one
+		size_type next = string_view_type::npos;
+		int count = 0;
+		bool at_end = true;
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef string_view_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const string_view_type* pointer;
+		typedef const string_view_type& reference;
+
+		iterator() = default;
+
+		explicit iterator( const basic_split_view *view_ )
+		: view( view_ ),
+		  next( 0 ),
+		  at_end( false )
+		{
+			advance();
+		}
+
+		reference operator*() const {
+			return token;
+		}
+
+		pointer operator->() const {
+			return &token;
+		}
+
+		iterator & operator++() {
+			advance();
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator it = *this;
+			advance();
+			return it;
+		}
+
+		bool operator==( const iterator & other ) const {
+			if( at_end || other.at_end ) {
+				return at_end == other.at_end;
+			}
+
+			return token.data() == other.token.data() && next == other.next;
+		}
+
+		bool operator!=( const iterator & other ) const {
+			return !(*this == other);
+		}
+
+	private:
+		void advance() {
+			if( next == string_view_type::npos ) {
+				at_end = true;
+				return;
+			}
+
+			const string_view_type & s = view->str;
+			const string_view_type & sep = view->sep;
+
+			if( view->max > 0 && ++count >= view->max ) {
+				token = s.substr( next );
+				next = string_view_type::npos;
+				return;
+			}
+
+			size_type pos = string_view_type::npos;
+
+			if( view->mode == Mode::STRING ) {
+				// an empty separator would never move forward
+				if( !sep.empty() ) {
+					pos = s.find( sep, next );
+				}
+			} else {
+				pos = view->sep_class.find_first_of( s.data(), s.size(), next );
+			}
+
+			if( pos == string_view_type::npos ) {
+				token = s.substr( next );
+				next = string_view_type::npos;
+				return;
+			}
+
+			token = s.substr( next, pos - next );
+
+			switch( view->mode ) {
+			case Mode::STRING:
+				next = pos + sep.size();
+				break;
+
+			case Mode::STRIP:
+				// the string is stripped, so there is always a token after the separators
+				next = view->sep_class.find_first_not_of( s.data(), s.size(), pos + 1 );
+				break;
+
+			case Mode::SIMPLE:
+				next = pos + 1;
+				break;
+			}
+		}
+	};
+
+	typedef iterator const_iterator;
+
+	basic_split_view( string_view_type str_, string_view_type sep_, int max_ = -1, Mode mode_ = Mode::SIMPLE )
+	: str( str_ ),
+	  sep( sep_ ),
+	  max( max_ ),
+	  mode( mode_ ),
+	  sep_class( sep.data(), mode == Mode::STRING ? 0 : sep.size() )
+	{
+		if( mode != Mode::STRING ) {
+			size_type first = sep_class.find_first_not_of( str.data(), str.size() );
+
+			if( first == sep_class.npos ) {
+				str = str.substr( str.size() );
+			} else {
+				str = str.substr( first, sep_class.find_last_not_of( str.data(), str.size() ) - first + 1 );
+			}
+		}
+	}
+
+	iterator begin() const {
+		// split_and_strip_simple() returns nothing for an empty string,
+		// split_simple() one empty token
+		if( mode == Mode::STRIP && str.empty() ) {
+			return end();
+		}
+
+		return iterator( this );
+	}
+
+	iterator end() const {
+		return iterator();
+	}
+
+	/**
+	 * returns the first token, or an empty one.
+	 * Handy for splitting 'key=value' like strings.
+	 */
+	string_view_type front() const {
+		iterator it = begin();
+
+		if( it == end() ) {
+			return string_view_type();
+		}
+
+		return *it;
+	}
+};
+
+typedef basic_split_view<char>    split_view_t;
+typedef basic_split_view<wchar_t> wsplit_view_t;
+
+/**
+ * Lazy split_simple(): the string is stripped by the separators,
+ * every separator character ends a token.
+ */
+inline split_view_t split_view( std::string_view str, std::string_view sep = " \t\n", int max = -1 )
+{
+	return split_view_t( str, sep, max, split_view_t::Mode::SIMPLE );
+}
+
+inline wsplit_view_t split_view( std::wstring_view str, std::wstring_view sep = L" \t\n", int max = -1 )
+{
+	return wsplit_view_t( str, sep, max, wsplit_view_t::Mode::SIMPLE );
+}
+
+/**
+ * Lazy split_and_strip_simple(): like split_view(),
+ * but a sequence of separators counts as one.
+ */
+inline split_view_t split_and_strip_view( std::string_view str, std::string_view sep = " \t\n", int max = -1 )
+{
+	return split_view_t( str, sep, max, split_view_t::Mode::STRIP );
+}
+
+inline wsplit_view_t split_and_strip_view( std::wstring_view str, std::wstring_view sep = L" \t\n", int max = -1 )
+{
+	return wsplit_view_t( str, sep, max, wsplit_view_t::Mode::STRIP );
+}
+
+/**
+ * Lazy split_string(): the whole separator string ends a token
+ */
+inline split_view_t split_string_view_lazy( std::string_view str, std::string_view sep, int max = -1 )
+{
+	return split_view_t( str, sep, max, split_view_t::Mode::STRING );
+}
+
+inline wsplit_view_t split_string_view_lazy( std::wstring_view str, std::wstring_view sep, int max = -1 )
+{
+	return wsplit_view_t( str, sep, max, wsplit_view_t::Mode::STRING );
+}
+
+} // namespace Tools
+
+#endif
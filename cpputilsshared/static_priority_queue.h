@@ -0,0 +1,288 @@
+/*
+ * @author Copyright (c) 2026 Martin Oberzalek
+ */
+
+#ifndef CPPUTILS_CPPUTILSSHARED_STATIC_PRIORITY_QUEUE_H_
+#define CPPUTILS_CPPUTILSSHARED_STATIC_PRIORITY_QUEUE_H_
+
+#include "static_vector.h"
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Tools {
+
+/**
+ * A bounded priority queue that uses no heap.
+ * The maximum capacity is defined at compile time.
+ *
+ * The elements are kept in a d-ary heap (Arity children per node)
+ * inside a static_vector. In difference to std::priority_queue the
+ * root of the heap is the *smallest* element according to Compare,
+ * because that is the one that has to be evicted, if the queue is full.
+ *
+ * So with the default Compare=std::less<T> the queue retains the N
+ * biggest values that have ever been pushed:
+ *
+ *   static_priority_queue<int,3> q;
+ *   for( int i : { 5, 1, 9, 7, 3 } ) {
+ *      q.push( i );
+ *   }
+ *   // q contains 5, 7, 9;  q.top() == 5
+ */
+template <typename T, std::size_t N, class Compare = std::less<T>, std::size_t Arity = 4>
+class static_priority_queue
+{
+	static_assert( N > 0, "capacity has to be at least 1" );
+	static_assert( Arity >= 2, "a heap node requires at least 2 children" );
+
+public:
+	typedef static_vector<T,N> container_type;
+	typedef typename container_type::value_type value_type;
+	typedef typename container_type::reference reference;
+	typedef typename container_type::const_reference const_reference;
+	typedef typename container_type::size_type size_type;
+	typedef typename container_type::const_iterator const_iterator;
+	typedef Compare value_compare;
+
+	static constexpr size_type arity = Arity;
+
+protected:
+	container_type data;
+	Compare comp;
+
+public:
+	static_priority_queue() = default;
+
+	explicit static_priority_queue( const Compare & comp_ )
+	: data(),
+	  comp( comp_ )
+	{}
+
+	static_priority_queue( const static_priority_queue & other ) = default;
+	static_priority_queue & operator=( const static_priority_queue & other ) = default;
+
+	constexpr size_type capacity() const {
+		return N;
+	}
+
+	size_type size() const {
+		return data.size();
+	}
+
+	bool empty() const {
+		return data.empty();
+	}
+
+	bool full() const {
+		return data.size() == N;
+	}
+
+	/**
+	 * returns the smallest retained element,
+	 * the one that will be evicted next.
+	 */
+	const_reference top() const {
+		if( data.empty() ) {
+#if __cpp_exceptions > 0
+			throw std::out_of_range("queue is empty");
+#else
+			std::abort();
+#endif
+		}
+
+		return data.front();
+	}
+
+	/**
+	 * Inserts the value. If the queue is full the smallest element
+	 * is evicted, or the value is discarded, if it is not bigger
+	 * than the smallest one.
+	 *
+	 * returns false if the value was discarded
+	 */
+	bool push( const T & value ) {
+		if( !full() ) {
+			data.push_back( value );
+			sift_up( data.size() - 1 );
+			return true;
+		}
+
+		if( !comp( data.front(), value ) ) {
+			return false;
+		}
+
+		data.front() = value;
+		sift_down( 0 );
+		return true;
+	}
+
+	bool push( T && value ) {
+		if( !full() ) {
+			data.push_back( std::move(value) );
+			sift_up( data.size() - 1 );
+			return true;
+		}
+
+		if( !comp( data.front(), value ) ) {
+			return false;
+		}
+
+		data.front() = std::move(value);
+		sift_down( 0 );
+		return true;
+	}
+
+	template< class... Args >
+	bool emplace( Args&&... args ) {
+		return push( T( std::forward<Args>(args)... ) );
+	}
+
+	/// removes the smallest element
+	void pop() {
+		if( data.empty() ) {
+#if __cpp_exceptions > 0
+			throw std::out_of_range("queue is empty");
+#else
+			std::abort();
+#endif
+		}
+
+		if( data.size() > 1 ) {
+			data.front() = std::move( data.back() );
+		}
+
+		data.pop_back();
+
+		if( !data.empty() ) {
+			sift_down( 0 );
+		}
+	}
+
+	void clear() {
+		data.clear();
+	}
+
+	/// the retained elements in heap order
+	const_iterator begin() const {
+		return data.begin();
+	}
+
+	const_iterator end() const {
+		return data.end();
+	}
+
+	/**
+	 * Moves all elements into a static_vector, biggest first.
+	 * The queue is empty afterwards.
+	 */
+	container_type drain_sorted() {
+		container_type res;
+		res.resize( data.size() );
+
+		for( size_type i = data.size(); i > 0; --i ) {
+			res[i-1] = std::move( data.front() );
+			pop();
+		}
+
+		return res;
+	}
+
+	void swap( static_priority_queue & other ) {
+		data.swap( other.data );
+		std::swap( comp, other.comp );
+	}
+
+protected:
+
+	static size_type parent( size_type pos ) {
+		return (pos - 1) / Arity;
+	}
+
+	static size_type first_child( size_type pos ) {
+		return pos * Arity + 1;
+	}
+
+	void sift_up( size_type pos ) {
+		T value = std::move( data[pos] );
+
+		while( pos > 0 ) {
+			size_type p = parent( pos );
+
+			if( !comp( value, data[p] ) ) {
+				break;
+			}
+
+			data[pos] = std::move( data[p] );
+			pos = p;
+		}
+
+		data[pos] = std::move( value );
+	}
+
+	void sift_down( size_type pos ) {
+		const size_type count = data.size();
+		T value = std::move( data[pos] );
+
+		while( true ) {
+			size_type child = first_child( pos );
+
+			if( child >= count ) {
+				break;
+			}
+
+			const size_type last_child = std::min( child + Arity, count );
+			size_type smallest = child;
+
+			for( ++child; child < last_child; ++child ) {
+				if( comp( data[child], data[smallest] ) ) {
+					smallest = child;
+				}
+			}
+
+			if( !comp( data[smallest], value ) ) {
+				break;
+			}
+
+			data[pos] = std::move( data[smallest] );
+			pos = smallest;
+		}
+
+		data[pos] = std::move( value );
+	}
+};
+
+/**
+ * Streams the values through a static_priority_queue and returns
+ * the K biggest ones (according to Compare), biggest first.
+ * Runtime is O(n log K), no heap allocation is done.
+ *
+ *   auto worst = top_k<10>( latencies.begin(), latencies.end() );
+ */
+template <std::size_t K, class InputIt,
+          class Compare = std::less<typename std::iterator_traits<InputIt>::value_type>>
+static_vector<typename std::iterator_traits<InputIt>::value_type,K>
+top_k( InputIt first, InputIt last, const Compare & comp = Compare() )
+{
+	static_priority_queue<typename std::iterator_traits<InputIt>::value_type,K,Compare> queue( comp );
+
+	for( ; first != last; ++first ) {
+		queue.push( *first );
+	}
+
+	return queue.drain_sorted();
+}
+
+template <std::size_t K, class Range,
+          class Compare = std::less<typename Range::value_type>>
+static_vector<typename Range::value_type,K>
+top_k( const Range & range, const Compare & comp = Compare() )
+{
+	return top_k<K>( std::begin(range), std::end(range), comp );
+}
+
+} // namespace Tools
+
+#endif /* CPPUTILS_CPPUTILSSHARED_STATIC_PRIORITY_QUEUE_H_ */
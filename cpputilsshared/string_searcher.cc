@@ -0,0 +1,136 @@
+/**
+ * SIMD variant of the substring search
+ * @author Copyright (c) 2026 Martin Oberzalek
+ */
+
+#include "string_searcher.h"
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#  define TOOLS_STRING_SEARCHER_X86
+#  include <immintrin.h>
+#endif
+
+namespace Tools {
+
+#ifdef TOOLS_STRING_SEARCHER_X86
+
+namespace {
+
+bool have_avx2()
+{
+	static const bool avx2 = []() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports( "avx2" ) != 0;
+	}();
+
+	return avx2;
+}
+
+// every bit in mask is a candidate, the first and the last character are matching
+inline bool check_candidates( unsigned mask, const char *block, const char *needle, size_t m, size_t & found )
+{
+	while( mask ) {
+		const unsigned bit = __builtin_ctz( mask );
+
+		if( memcmp( block + bit + 1, needle + 1, m - 2 ) == 0 ) {
+			found = bit;
+			return true;
+		}
+
+		mask &= mask - 1;
+	}
+
+	return false;
+}
+
+// SSE2 is always available on x86_64
+size_t find_sse2( const char *haystack, size_t len, size_t & pos, const char *needle, size_t m )
+{
+	const __m128i first = _mm_set1_epi8( needle[0] );
+	const __m128i last = _mm_set1_epi8( needle[m - 1] );
+	size_t found;
+
+	for( ; pos + m - 1 + 16 <= len; pos += 16 ) {
+		const __m128i block_first = _mm_loadu_si128( reinterpret_cast<const __m128i*>( haystack + pos ) );
+		const __m128i block_last = _mm_loadu_si128( reinterpret_cast<const __m128i*>( haystack + pos + m - 1 ) );
+		const __m128i eq = _mm_and_si128( _mm_cmpeq_epi8( first, block_first ), _mm_cmpeq_epi8( last, block_last ) );
+
+		if( check_candidates( static_cast<unsigned>( _mm_movemask_epi8( eq ) ), haystack + pos, needle, m, found ) ) {
+			return pos + found;
+		}
+	}
+
+	return basic_string_searcher<char>::npos;
+}
+
+__attribute__((target("avx2")))
+size_t find_avx2( const char *haystack, size_t len, size_t & pos, const char *needle, size_t m )
+{
+	const __m256i first = _mm256_set1_epi8( needle[0] );
+	const __m256i last = _mm256_set1_epi8( needle[m - 1] );
+	size_t found;
+
+	// two blocks at once, most of them have no candidates at all
+	for( ; pos + m - 1 + 64 <= len; pos += 64 ) {
+		const char *p = haystack + pos;
+		const __m256i eq1 = _mm256_and_si256( _mm256_cmpeq_epi8( first, _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) ) ),
+											  _mm256_cmpeq_epi8( last, _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + m - 1 ) ) ) );
+		const __m256i eq2 = _mm256_and_si256( _mm256_cmpeq_epi8( first, _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + 32 ) ) ),
+											  _mm256_cmpeq_epi8( last, _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + 32 + m - 1 ) ) ) );
+
+		if( _mm256_testz_si256( _mm256_or_si256( eq1, eq2 ), _mm256_or_si256( eq1, eq2 ) ) ) {
+			continue;
+		}
+
+		if( check_candidates( static_cast<unsigned>( _mm256_movemask_epi8( eq1 ) ), p, needle, m, found ) ) {
+			return pos + found;
+		}
+
+		if( check_candidates( static_cast<unsigned>( _mm256_movemask_epi8( eq2 ) ), p + 32, needle, m, found ) ) {
+			return pos + 32 + found;
+		}
+	}
+
+	for( ; pos + m - 1 + 32 <= len; pos += 32 ) {
+		const __m256i block_first = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( haystack + pos ) );
+		const __m256i block_last = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( haystack + pos + m - 1 ) );
+		const __m256i eq = _mm256_and_si256( _mm256_cmpeq_epi8( first, block_first ), _mm256_cmpeq_epi8( last, block_last ) );
+
+		if( check_candidates( static_cast<unsigned>( _mm256_movemask_epi8( eq ) ), haystack + pos, needle, m, found ) ) {
+			return pos + found;
+		}
+	}
+
+	return basic_string_searcher<char>::npos;
+}
+
+} // namespace
+
+template <>
+size_t basic_string_searcher<char>::find_simd( const char *haystack, size_t len, size_t & pos ) const
+{
+	const size_t m = needle.size();
+
+	if( have_avx2() ) {
+		const size_t res = find_avx2( haystack, len, pos, needle.data(), m );
+
+		if( res != npos ) {
+			return res;
+		}
+	}
+
+	return find_sse2( haystack, len, pos, needle.data(), m );
+}
+
+#else
+
+template <>
+size_t basic_string_searcher<char>::find_simd( const char *, size_t, size_t & ) const
+{
+	return npos;
+}
+
+#endif
+
+} // namespace Tools
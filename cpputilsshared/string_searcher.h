@@ -0,0 +1,200 @@
+/**
+ * Substring search, that chooses the algorithm by the length of the needle
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::string_searcher searcher( "ERROR" );
+ *
+ *    searcher.find_all( dump.data(), dump.size(), [&]( size_t pos ) {
+ *       report( pos );
+ *       return true;   // false stops the search
+ *    });
+ *
+ * Algorithms:
+ *    1 character:         memchr()
+ *    std::string:         the first and the last character of the needle are
+ *                         compared with 32 (AVX2) or 16 (SSE2) positions at once,
+ *                         only the candidates are compared completely.
+ *    without SIMD:        less than 32 characters: memchr() for the first character,
+ *                         32 and more: Boyer-Moore-Horspool, skips up to the needle size.
+ *
+ * A searcher is immutable, so it can be shared between threads.
+ * For searching on several threads see thread/parallel_find.h
+ */
+#ifndef TOOLS_STRING_SEARCHER_H
+#define TOOLS_STRING_SEARCHER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Tools {
+
+template <class CharT>
+class basic_string_searcher
+{
+public:
+	typedef std::basic_string<CharT> string_type;
+	typedef std::char_traits<CharT> traits_type;
+
+	static const size_t npos = static_cast<size_t>(-1);
+	static const size_t HORSPOOL_MIN_LENGTH = 32;
+
+private:
+	string_type needle;
+
+	// Horspool: the shift for the last character of the window,
+	// by its lowest byte, so it also works for wide characters.
+	std::vector<size_t> shift;
+
+public:
+	basic_string_searcher( const CharT *needle_, size_t len )
+	: needle( needle_, len )
+	{
+		init();
+	}
+
+	explicit basic_string_searcher( const string_type & needle_ )
+	: needle( needle_ )
+	{
+		init();
+	}
+
+	const string_type & getNeedle() const {
+		return needle;
+	}
+
+	size_t size() const {
+		return needle.size();
+	}
+
+	/**
+	 * Returns the first position >= pos, or npos.
+	 * An empty needle is never found.
+	 */
+	size_t find( const CharT *haystack, size_t len, size_t pos = 0 ) const {
+		const size_t m = needle.size();
+
+		if( m == 0 || pos >= len || len - pos < m ) {
+			return npos;
+		}
+
+		if( m == 1 ) {
+			const CharT *p = traits_type::find( haystack + pos, len - pos, needle[0] );
+			return p ? static_cast<size_t>( p - haystack ) : npos;
+		}
+
+		const size_t res = find_simd( haystack, len, pos );
+
+		if( res != npos ) {
+			return res;
+		}
+
+		// the rest, that was too short for SIMD, or everything without SIMD
+		if( m >= HORSPOOL_MIN_LENGTH ) {
+			return find_horspool( haystack, len, pos );
+		}
+
+		return find_short( haystack, len, pos );
+	}
+
+	/**
+	 * Calls func( size_t pos ) for every match, like find_all_of().
+	 * The matches are not overlapping. If func returns false, the search stops.
+	 */
+	template <class Func>
+	void find_all( const CharT *haystack, size_t len, Func && func, size_t pos = 0 ) const {
+		while( (pos = find( haystack, len, pos )) != npos ) {
+			if( !func( pos ) ) {
+				return;
+			}
+
+			pos += needle.size();
+		}
+	}
+
+private:
+	static unsigned low_byte( CharT c ) {
+		return static_cast<unsigned>( static_cast<typename std::make_unsigned<CharT>::type>( c ) ) & 0xff;
+	}
+
+	void init() {
+		const size_t m = needle.size();
+
+		if( m < HORSPOOL_MIN_LENGTH ) {
+			return;
+		}
+
+		shift.assign( 256, m );
+
+		// later characters get smaller shifts, so a collision
+		// of the low bytes can only make the shift smaller
+		for( size_t i = 0; i + 1 < m; ++i ) {
+			shift[low_byte( needle[i] )] = m - 1 - i;
+		}
+	}
+
+	/**
+	 * Checks blocks of positions with SIMD. Returns the first match, or npos.
+	 * pos is set to the first position, that was not checked yet.
+	 */
+	size_t find_simd( const CharT *haystack, size_t len, size_t & pos ) const;
+
+	size_t find_short( const CharT *haystack, size_t len, size_t pos ) const {
+		const size_t m = needle.size();
+		const CharT first = needle[0];
+
+		while( pos + m <= len ) {
+			const CharT *p = traits_type::find( haystack + pos, len - m + 1 - pos, first );
+
+			if( !p ) {
+				return npos;
+			}
+
+			pos = static_cast<size_t>( p - haystack );
+
+			if( traits_type::compare( p + 1, needle.data() + 1, m - 1 ) == 0 ) {
+				return pos;
+			}
+
+			++pos;
+		}
+
+		return npos;
+	}
+
+	size_t find_horspool( const CharT *haystack, size_t len, size_t pos ) const {
+		const size_t m = needle.size();
+		const CharT last = needle[m - 1];
+
+		while( pos + m <= len ) {
+			const CharT c = haystack[pos + m - 1];
+
+			if( c == last && traits_type::compare( haystack + pos, needle.data(), m - 1 ) == 0 ) {
+				return pos;
+			}
+
+			pos += shift[low_byte( c )];
+		}
+
+		return npos;
+	}
+};
+
+template <class CharT>
+inline size_t basic_string_searcher<CharT>::find_simd( const CharT *, size_t, size_t & ) const
+{
+	return npos;
+}
+
+// only char has a SIMD variant
+template <> size_t basic_string_searcher<char>::find_simd( const char *haystack, size_t len, size_t & pos ) const;
+
+typedef basic_string_searcher<char>    string_searcher;
+typedef basic_string_searcher<wchar_t> wstring_searcher;
+
+} // namespace Tools
+
+#endif
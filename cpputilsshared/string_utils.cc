@@ -110,7 +110,7 @@ std::wstring strip( const std::wstring& str, const std::wstring& what ) {
 
 std::string strip_leading( const std::string& str, const std::string& what )
 {
-    std::string::size_type p = str.find_first_not_of(what);
+    std::string::size_type p = find_first_not_of_class( str, what );
     
     if( p == std::string::npos )
     {
@@ -122,7 +122,7 @@ std::string strip_leading( const std::string& str, const std::string& what )
 
 std::wstring strip_leading( const std::wstring& str, const std::wstring& what )
 {
-    std::wstring::size_type p = str.find_first_not_of(what);
+    std::wstring::size_type p = find_first_not_of_class( str, what );
 
     if( p == std::wstring::npos )
     {
@@ -134,7 +134,7 @@ std::wstring strip_leading( const std::wstring& str, const std::wstring& what )
 
 std::string strip_trailing( const std::string& str, const std::string& what )
 {
-    std::string::size_type p = str.find_last_not_of(what);
+    std::string::size_type p = find_last_not_of_class( str, what );
     
     if( p == std::string::npos )
     {
@@ -146,7 +146,7 @@ std::string strip_trailing( const std::string& str, const std::string& what )
 
 std::wstring strip_trailing( const std::wstring& str, const std::wstring& what )
 {
-    std::wstring::size_type p = str.find_last_not_of(what);
+    std::wstring::size_type p = find_last_not_of_class( str, what );
 
     if( p == std::wstring::npos )
     {
@@ -204,7 +204,9 @@ template<class t_std_string> class TSplitSimple {
 public:
 	std::vector<t_std_string> split_simple( t_std_string str, t_std_string sep, int max )
 	{
-		str = strip( str, sep );
+		basic_char_class<typename t_std_string::value_type> cc( sep.data(), sep.size() );
+		TStrip<t_std_string> tstrip;
+		str = tstrip.strip( str, cc );
 
 		typename t_std_string::size_type start = 0, last = 0;
 		int count = 0;
@@ -224,9 +226,9 @@ public:
 			}
 
 
-			start = str.find_first_of( sep, last );
+			start = cc.find_first_of( str.data(), str.size(), last );
 
-			if( start == std::string::npos )
+			if( start == cc.npos )
 			{
 				sl.push_back( str.substr( last ) );
 				break;
@@ -502,157 +504,22 @@ std::string escape( const std::string &s )
     return substitude( s, "'", "\\'" );
 }
 
-template <class character_type> struct Pair
-{
-  typename std::basic_string<character_type>::size_type start;
-  typename std::basic_string<character_type>::size_type end;
-
-  Pair( typename std::basic_string<character_type>::size_type start_, typename std::basic_string<character_type>::size_type end_ )
-    : start( start_ ),
-	  end( end_ )
-  {}
-};
-
-
-static bool is_escaped( const std::string &s, std::string::size_type start )
-{
-	bool escaped = false;
-
-	if( start > 0 ) {
-		if( s[start-1] == '\\' ) {
-			escaped = true;
-
-			if( start > 1 )	{
-				if( s[start-2] == '\\' ) {
-					escaped = false;
-				}
-			}
-		}
-	}
-
-	return escaped;
-}
-
-static bool is_escaped( const std::wstring &s, std::wstring::size_type start )
-{
-	bool escaped = false;
-
-	if( start > 0 ) {
-		if( s[start-1] == L'\\' ) {
-			escaped = true;
-
-			if( start > 1 ) {
-				if( s[start-2] == L'\\' ) {
-					escaped = false;
-				}
-			}
-		}
-	}
-
-	return escaped;
-}
-
-template <class t_std_string>
-static std::vector<Pair<typename t_std_string::value_type>> find_exclusive( const t_std_string &s )
-{
-	std::vector<Pair<typename t_std_string::value_type>> ex;
-
-	std::string::size_type pos = 0, start = 0, end = 0;
-
-	while( true )
-	{
-
-		/* find starting pos */
-		while( true )
-		{
-			start = s.find( '"', pos );
-
-			if( start == t_std_string::npos )
-				return ex;
-
-			/* is the " escaped? */
-			if( is_escaped( s, start ) )
-			{
-				pos = start + 1;
-				continue;
-			}
-
-			break;
-		}
-
-		// find second "
-		pos = start + 1;
-		while( true )
-		{
-			end = s.find( '"', pos );
-
-			if( end == t_std_string::npos )
-				return ex;
-
-			if( is_escaped( s, end ) )
-			{
-				pos = end + 1;
-				continue;
-			}
-
-			break;
-		}
-
-		ex.push_back( Pair<typename t_std_string::value_type>( start, end ) );
-		pos = end + 1;
-	}
-}
-
-template <class t_std_string>
-static bool is_exclusive( const t_std_string &s,
-						  const std::vector<Pair<typename t_std_string::value_type>> &exclude,
-						  typename t_std_string::size_type pos1 )
-{
-	bool exclusive = false;
-	for( unsigned i = 0; i < exclude.size(); i++ ) {
-		if( exclude[i].start < pos1 &&
-				exclude[i].end > pos1 )
-		{
-			exclusive = true;
-			break;
-		}
-	}
-
-	return exclusive;
-}
-
 /* splits
        hello "my name is" 
    correct up into 'hello' and '"my name is"'
+   see tokenizer.h for the details
 */
 template <class t_std_string>
 static std::vector<t_std_string> split_safe_int( const t_std_string &s, const t_std_string &sep )
 {
-  std::vector<Pair<typename t_std_string::value_type>> exclude = find_exclusive( s );
-
-  typename t_std_string::size_type pos1 = 0, pos2 = 0;
+  basic_safe_tokenizer<typename t_std_string::value_type> tokenizer( s.data(), s.size(), sep.data(), sep.size() );
 
   std::vector<t_std_string> sl;
+  size_t start, len;
 
-  while( true )
+  while( tokenizer.next( start, len ) )
   {
-	  pos1 = s.find_first_of( sep, pos1 );
-
-	  if( pos1 == t_std_string::npos )
-	  {
-		  sl.push_back( s.substr( pos2 ) );
-		  return sl;
-	  }
-
-	  if( is_exclusive( s, exclude, pos1 ) )
-	  {
-		  pos1++;
-		  continue;
-	  }
-
-	  sl.push_back( s.substr( pos2, pos1 - pos2 ) );
-	  pos2 = pos1 + 1;
-	  pos1++;
+	  sl.push_back( s.substr( start, len ) );
   }
 
   return sl;
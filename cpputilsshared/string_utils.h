@@ -9,6 +9,20 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <type_traits>
+#include "char_class.h"
+#include "string_searcher.h"
+#include "tokenizer.h"
+
+#if __cplusplus >= 201703L
+#  include <charconv>
+#  define TOOLS_HAVE_CHARCONV
+#endif
+
+#if __cplusplus >= 201703L
+#  include "split_view.h"
+#  include "substitute_many.h"
+#endif
 
 #define HAVE_STL_SSTREAM
 
@@ -47,18 +61,24 @@ namespace detail {
 
 		t_std_string strip( const t_std_string& str, const t_std_string& what )
 		{
-			typename t_std_string::size_type p = str.find_first_not_of(what);
+			basic_char_class<typename t_std_string::value_type> cc( what.data(), what.size() );
+			return strip( str, cc );
+		}
+
+		t_std_string strip( const t_std_string& str, const basic_char_class<typename t_std_string::value_type> & what )
+		{
+			size_t p = what.find_first_not_of( str.data(), str.size() );
 
-			if( p == std::string::npos )
+			if( p == what.npos )
 			{
 				return t_std_string();
 
 			} else {
 
-				typename t_std_string::size_type q = str.find_last_not_of(what);
-				typename t_std_string::size_type len = q - p + 1;
+				size_t q = what.find_last_not_of( str.data(), str.size() );
+				size_t len = q - p + 1;
 
-				return t_std_string(&(*str.begin()) + p, len );
+				return t_std_string(str.data() + p, len );
 			}
 		}
 	};
@@ -67,8 +87,9 @@ namespace detail {
 	template<class t_std_string, class t_container=std::vector<t_std_string>>
 	void split_and_strip_simple_int( const t_std_string & input_str, const t_std_string & sep , int max, std::function<void(t_std_string)> back_inserter )
 	{
+	  basic_char_class<typename t_std_string::value_type> cc( sep.data(), sep.size() );
 	  TStrip<t_std_string> tstrip;
-	  t_std_string str = tstrip.strip( input_str, sep );
+	  t_std_string str = tstrip.strip( input_str, cc );
 
 	  std::string::size_type start = 0, last = 0;
 	  int count = 0;
@@ -88,9 +109,9 @@ namespace detail {
 		  break;
 		}
 
-		start = str.find_first_of( sep, last );
+		start = cc.find_first_of( str.data(), str.size(), last );
 
-		if( start == t_std_string::npos )
+		if( start == cc.npos )
 		{
 		  back_inserter( str.substr( last ) );
 		  break;
@@ -98,28 +119,8 @@ namespace detail {
 
 		back_inserter( str.substr( last, start - last ) );
 
-		for( typename t_std_string::size_type pos = start + 1;
-		  pos < str.size(); pos++ )
-		{
-		  bool found = false;
-
-		  for( typename t_std_string::size_type i = 0; i < sep.size(); i++ )
-		  {
-			if( str[pos] == sep[i] )
-			{
-			  found = true;
-			  break;
-			}
-		  }
-
-		  if( found == false )
-		  {
-			last = pos;
-			break;
-		  }
-		}
-
-		//      last = start + 1;
+		// the string is stripped, so there is always a character left
+		last = cc.find_first_not_of( str.data(), str.size(), start + 1 );
 	  }
 	}
 
@@ -204,9 +205,130 @@ template<class T> T get_bool( bool b ) { return T(); }
 bool s2bool( const std::string &s );
 bool s2bool( const std::wstring &s );
 
+#ifdef TOOLS_HAVE_CHARCONV
+namespace detail {
+
+template <class T> struct is_char_type : std::false_type {};
+template <> struct is_char_type<char> : std::true_type {};
+template <> struct is_char_type<signed char> : std::true_type {};
+template <> struct is_char_type<unsigned char> : std::true_type {};
+template <> struct is_char_type<wchar_t> : std::true_type {};
+template <> struct is_char_type<char16_t> : std::true_type {};
+template <> struct is_char_type<char32_t> : std::true_type {};
+#if __cpp_char8_t >= 201811L
+template <> struct is_char_type<char8_t> : std::true_type {};
+#endif
+
+/**
+ * types, that s2x() and x2s() are converting with std::from_chars()
+ * and std::to_chars(). Characters are read and written as they are
+ * by the streams, so they are not numbers here.
+ */
+template <class T> struct use_charconv : std::integral_constant<bool,
+#if __cpp_lib_to_chars >= 201611L
+	std::is_arithmetic<T>::value &&
+#else
+	std::is_integral<T>::value &&
+#endif
+	!std::is_same<T,bool>::value &&
+	!is_char_type<T>::value> {};
+
+template <class CharT> inline bool is_stream_space( CharT c )
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+template <class CharT> inline bool is_digit( CharT c )
+{
+	return c >= '0' && c <= '9';
+}
+
+/**
+ * Converts a plain number, that can be followed by white space.
+ * Returns false for everything else, like an empty string, a leading '+',
+ * trailing garbage or an overflow. The caller falls back to the stream then,
+ * so the results are exactly the same.
+ */
+template <class T, class CharT>
+bool s2x_charconv( const CharT *first, const CharT *last, T & value )
+{
+	while( first != last && is_stream_space( *first ) ) {
+		++first;
+	}
+
+	const size_t len = static_cast<size_t>( last - first );
+	char buffer[64];
+	const char *p;
+
+	if constexpr( std::is_same<CharT,char>::value ) {
+		p = first;
+	} else {
+		if( len > sizeof(buffer) ) {
+			return false;
+		}
+
+		for( size_t i = 0; i < len; ++i ) {
+			if( static_cast<unsigned long>( first[i] ) > 127 ) {
+				return false;
+			}
+			buffer[i] = static_cast<char>( first[i] );
+		}
+
+		p = buffer;
+	}
+
+	const char *end = p + len;
+
+	if( p == end ) {
+		return false;
+	}
+
+	// the stream reads "-1" into an unsigned as well, and does not know inf and nan
+	if( !is_digit( *p ) ) {
+		const bool floating = std::is_floating_point<T>::value;
+		const bool negative = std::is_signed<T>::value && *p == '-' && len > 1 &&
+			(is_digit( p[1] ) || (floating && p[1] == '.'));
+
+		if( !negative && !(floating && *p == '.') ) {
+			return false;
+		}
+	}
+
+	std::from_chars_result res = std::from_chars( p, end, value );
+
+	if( res.ec != std::errc() ) {
+		return false;
+	}
+
+	return res.ptr == end || is_stream_space( *res.ptr );
+}
+
+// writes the number like the stream does with its default settings
+template <class T>
+std::to_chars_result x2s_charconv( char *first, char *last, T value )
+{
+	if constexpr( std::is_floating_point<T>::value ) {
+		return std::to_chars( first, last, value, std::chars_format::general, 6 );
+	} else {
+		return std::to_chars( first, last, value );
+	}
+}
+
+} // namespace detail
+#endif
+
 /// convert a string to anything
 template <class T> T s2x( const std::string& s )
 {
+#ifdef TOOLS_HAVE_CHARCONV
+  if constexpr( detail::use_charconv<T>::value ) {
+    T t;
+    if( detail::s2x_charconv( s.data(), s.data() + s.size(), t ) ) {
+      return t;
+    }
+  }
+#endif
+
     if( is_bool( T() ) )
     {
       bool b = s2bool( s );
@@ -231,6 +353,15 @@ template <class T> T s2x( const std::string& s )
 /// convert a string to anything
 template <class T> T s2x( const std::string& s, const T & init )
 {
+#ifdef TOOLS_HAVE_CHARCONV
+  if constexpr( detail::use_charconv<T>::value ) {
+    T t;
+    if( detail::s2x_charconv( s.data(), s.data() + s.size(), t ) ) {
+      return t;
+    }
+  }
+#endif
+
     if( is_bool( T() ) )
     {
 	return s2bool( s );
@@ -253,6 +384,15 @@ template <class T> T s2x( const std::string& s, const T & init )
 /// convert a string to anything
 template <class T> T s2x( const std::wstring& s, const T & init )
 {
+#ifdef TOOLS_HAVE_CHARCONV
+  if constexpr( detail::use_charconv<T>::value ) {
+    T t;
+    if( detail::s2x_charconv( s.data(), s.data() + s.size(), t ) ) {
+      return t;
+    }
+  }
+#endif
+
     if( is_bool( T() ) )
     {
 	return s2bool( s );
@@ -271,6 +411,17 @@ template <class T> T s2x( const std::wstring& s, const T & init )
 /// converts anything to a string
 template<class T>std::string x2s( T what )
 {
+#ifdef TOOLS_HAVE_CHARCONV
+  if constexpr( detail::use_charconv<T>::value ) {
+    char buffer[64];
+    std::to_chars_result res = detail::x2s_charconv( buffer, buffer + sizeof(buffer), what );
+
+    if( res.ec == std::errc() ) {
+      return std::string( buffer, res.ptr );
+    }
+  }
+#endif
+
   std::strstream str;
   
   str << what ENDS;
@@ -287,6 +438,17 @@ template<class T>std::string x2s( T what )
 /// converts anything to a string
 template<class T> std::wstring x2ws( T what )
 {
+#ifdef TOOLS_HAVE_CHARCONV
+  if constexpr( detail::use_charconv<T>::value ) {
+    char buffer[64];
+    std::to_chars_result res = detail::x2s_charconv( buffer, buffer + sizeof(buffer), what );
+
+    if( res.ec == std::errc() ) {
+      return std::wstring( buffer, res.ptr );
+    }
+  }
+#endif
+
   std::wstringstream str;
 
   str << what;
@@ -485,34 +647,33 @@ inline bool is_empty_string(  const std::wstring & s ) {  return is_empty_str( s
 /**
  * find all occurences of the needle in the haystack
  * and passes the found position to the func()
+ * The matches are not overlapping. If func returns false the search stops.
+ * An empty needle is never found. See string_searcher.h for the algorithms.
  */
-template <class t_std_string>
+template <class t_std_string, class Func>
 void find_all_of_t( const t_std_string & haystack,
 				  const t_std_string & needle,
-				  std::function< bool(typename t_std_string::size_type) > func )
+				  Func && func )
 {
-	typename t_std_string::size_type start = 0;
-	typename t_std_string::size_type pos;
+	basic_string_searcher<typename t_std_string::value_type> searcher( needle.data(), needle.size() );
 
-	while( (pos = haystack.find( needle, start ) ) != t_std_string::npos ) {
-		if( !func( pos ) ) {
-			return;
-		}
-
-		start = pos + needle.size();
-	}
+	searcher.find_all( haystack.data(), haystack.size(), [&func]( size_t pos ) {
+		return func( static_cast<typename t_std_string::size_type>( pos ) );
+	});
 }
 
+template <class Func>
 inline void find_all_of( const std::wstring & haystack,
 				  	  	 const std::wstring & needle,
-						 std::function< bool(typename std::wstring::size_type) > func )
+						 Func && func )
 {
 	find_all_of_t<std::wstring>( haystack, needle, func );
 }
 
+template <class Func>
 inline void find_all_of( const std::string & haystack,
 				  	  	 const std::string & needle,
-						 std::function< bool(typename std::string::size_type) > func )
+						 Func && func )
 {
 	find_all_of_t<std::string>( haystack, needle, func );
 }
@@ -550,5 +711,6 @@ container find_all_of( const std::wstring & haystack,
 #undef STRSTREAM
 #undef strstream
 #undef ENDS
+#undef TOOLS_HAVE_CHARCONV
 
 #endif
@@ -0,0 +1,331 @@
+/**
+ * Replacing many patterns at once, with an Aho-Corasick automaton
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    std::string html = Tools::substitute_many( text, { { "&", "&amp;" },
+ *                                                        { "<", "&lt;" },
+ *                                                        { ">", "&gt;" } } );
+ *
+ *    // building the automaton once, and reusing it
+ *    static const Tools::Substitutor escape_sql( { { "'", "''" }, { "\\", "\\\\" } } );
+ *    std::string s = escape_sql.apply( value );
+ *
+ * The text is scanned once. If several patterns are matching, the one,
+ * that starts first wins, and of those the longest one. The replaced
+ * text is not scanned again, so a replacement can contain patterns.
+ * For a single pattern the result is the same as the one of substitude().
+ *
+ * A Substitutor is immutable after construction, apply() can be
+ * called by several threads at the same time.
+ */
+#ifndef TOOLS_SUBSTITUTE_MANY_H
+#define TOOLS_SUBSTITUTE_MANY_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <deque>
+#include <algorithm>
+#include <initializer_list>
+#include <cstdint>
+#include <type_traits>
+
+namespace Tools {
+
+template <class CharT>
+class basic_substitutor
+{
+public:
+	typedef std::basic_string<CharT> string_type;
+	typedef std::pair<string_type,string_type> replacement_type;
+
+private:
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	struct State
+	{
+		// sorted by character
+		std::vector<std::pair<CharT,uint32_t>> edges;
+		uint32_t fail = 0;
+
+		// the next state on the fail chain, that ends a pattern
+		uint32_t output_link = NONE;
+
+		// the pattern, that ends here, NONE: none
+		uint32_t pattern = NONE;
+		uint32_t depth = 0;
+	};
+
+	std::vector<State> states;
+	std::vector<replacement_type> replacements;
+
+	// transitions of the root for characters < 256
+	uint32_t root_edges[256];
+
+	size_t max_length = 0;
+	bool shrinking = true;
+
+public:
+	basic_substitutor( std::initializer_list<replacement_type> list )
+	{
+		build( list.begin(), list.end() );
+	}
+
+	// any container of std::pair<string_type,string_type>
+	template <class Container>
+	explicit basic_substitutor( const Container & list )
+	{
+		build( list.begin(), list.end() );
+	}
+
+	/**
+	 * returns a copy of str with all patterns replaced.
+	 * Like substitude() the characters before start are left untouched.
+	 */
+	string_type apply( const string_type & str, size_t start = 0 ) const;
+
+	size_t size() const {
+		return replacements.size();
+	}
+
+private:
+	static unsigned uchar( CharT c ) {
+		return static_cast<unsigned>( static_cast<typename std::make_unsigned<CharT>::type>( c ) );
+	}
+
+	uint32_t find_edge( uint32_t state, CharT c ) const {
+		if( state == 0 && uchar( c ) < 256 ) {
+			return root_edges[uchar( c )];
+		}
+
+		const std::vector<std::pair<CharT,uint32_t>> & edges = states[state].edges;
+
+		auto it = std::lower_bound( edges.begin(), edges.end(), c,
+									[]( const std::pair<CharT,uint32_t> & e, CharT ch ) { return e.first < ch; } );
+
+		if( it != edges.end() && it->first == c ) {
+			return it->second;
+		}
+
+		return NONE;
+	}
+
+	uint32_t next_state( uint32_t state, CharT c ) const {
+		for( ;; ) {
+			uint32_t next = find_edge( state, c );
+
+			if( next != NONE ) {
+				return next;
+			}
+
+			if( state == 0 ) {
+				return 0;
+			}
+
+			state = states[state].fail;
+		}
+	}
+
+	template <class Iterator>
+	void build( Iterator begin, Iterator end );
+};
+
+template <class CharT>
+template <class Iterator>
+void basic_substitutor<CharT>::build( Iterator begin, Iterator end )
+{
+	states.emplace_back();
+	std::fill( root_edges, root_edges + 256, NONE );
+
+	for( Iterator it = begin; it != end; ++it ) {
+		const string_type & what = it->first;
+
+		// like substitude(), an empty pattern is ignored
+		if( what.empty() ) {
+			continue;
+		}
+
+		uint32_t state = 0;
+
+		for( CharT c : what ) {
+			uint32_t next = find_edge( state, c );
+
+			if( next == NONE ) {
+				next = static_cast<uint32_t>( states.size() );
+				states.emplace_back();
+				states[next].depth = states[state].depth + 1;
+
+				auto & edges = states[state].edges;
+				edges.insert( std::upper_bound( edges.begin(), edges.end(), std::make_pair( c, uint32_t(0) ),
+												[]( const std::pair<CharT,uint32_t> & a, const std::pair<CharT,uint32_t> & b ) { return a.first < b.first; } ),
+							  std::make_pair( c, next ) );
+
+				if( state == 0 && uchar( c ) < 256 ) {
+					root_edges[uchar( c )] = next;
+				}
+			}
+
+			state = next;
+		}
+
+		// the first one wins for duplicates
+		if( states[state].pattern == NONE ) {
+			states[state].pattern = static_cast<uint32_t>( replacements.size() );
+			replacements.emplace_back( it->first, it->second );
+
+			max_length = std::max( max_length, what.size() );
+			shrinking = shrinking && it->second.size() <= what.size();
+		}
+	}
+
+	// fail links, breadth first
+	std::deque<uint32_t> queue;
+
+	for( const auto & edge : states[0].edges ) {
+		states[edge.second].fail = 0;
+		queue.push_back( edge.second );
+	}
+
+	while( !queue.empty() ) {
+		const uint32_t state = queue.front();
+		queue.pop_front();
+
+		for( const auto & edge : states[state].edges ) {
+			const uint32_t child = edge.second;
+			uint32_t fail = states[state].fail;
+
+			for( ;; ) {
+				uint32_t next = find_edge( fail, edge.first );
+
+				if( next != NONE && next != child ) {
+					states[child].fail = next;
+					break;
+				}
+
+				if( fail == 0 ) {
+					states[child].fail = 0;
+					break;
+				}
+
+				fail = states[fail].fail;
+			}
+
+			const State & f = states[states[child].fail];
+			states[child].output_link = f.pattern != NONE ? states[child].fail : f.output_link;
+
+			queue.push_back( child );
+		}
+	}
+}
+
+template <class CharT>
+typename basic_substitutor<CharT>::string_type basic_substitutor<CharT>::apply( const string_type & str, size_t start ) const
+{
+	if( start >= str.size() || replacements.empty() ) {
+		return str;
+	}
+
+	string_type res;
+	res.reserve( shrinking ? str.size() : str.size() + str.size() / 4 );
+	res.append( str, 0, start );
+
+	/*
+	 * best[p % window] is the index + 1 of the longest pattern starting at p.
+	 * A position is written to the output, when no pattern can start
+	 * there any more, so only the last max_length positions are needed.
+	 */
+	size_t window = 1;
+
+	while( window < max_length ) {
+		window <<= 1;
+	}
+
+	std::vector<uint32_t> best( window, 0 );
+	const size_t mask = window - 1;
+
+	size_t out = start;
+	uint32_t state = 0;
+
+	auto flush = [&]( size_t limit ) {
+		while( out < limit ) {
+			const uint32_t p = best[out & mask];
+
+			if( p == 0 ) {
+				res += str[out++];
+				continue;
+			}
+
+			const replacement_type & r = replacements[p - 1];
+			res += r.second;
+
+			for( size_t i = 0; i < r.first.size(); ++i ) {
+				best[(out + i) & mask] = 0;
+			}
+
+			out += r.first.size();
+		}
+	};
+
+	for( size_t i = start; i < str.size(); ++i ) {
+		state = next_state( state, str[i] );
+
+		uint32_t s = states[state].pattern != NONE ? state : states[state].output_link;
+
+		for( ; s != NONE; s = states[s].output_link ) {
+			const size_t len = states[s].depth;
+			const size_t begin = i + 1 - len;
+
+			// overlaps an already replaced pattern
+			if( begin < out ) {
+				continue;
+			}
+
+			uint32_t & b = best[begin & mask];
+
+			if( b == 0 || replacements[b - 1].first.size() < len ) {
+				b = states[s].pattern + 1;
+			}
+		}
+
+		// no pattern, that starts at or before i + 1 - max_length, is unknown now
+		if( i + 2 >= max_length ) {
+			flush( i + 2 - max_length );
+		}
+	}
+
+	flush( str.size() );
+
+	return res;
+}
+
+typedef basic_substitutor<char>    Substitutor;
+typedef basic_substitutor<wchar_t> WSubstitutor;
+
+inline std::string substitute_many( const std::string & str, const Substitutor & substitutor, std::string::size_type start = 0 )
+{
+	return substitutor.apply( str, start );
+}
+
+inline std::wstring substitute_many( const std::wstring & str, const WSubstitutor & substitutor, std::wstring::size_type start = 0 )
+{
+	return substitutor.apply( str, start );
+}
+
+inline std::string substitute_many( const std::string & str,
+									std::initializer_list<Substitutor::replacement_type> replacements,
+									std::string::size_type start = 0 )
+{
+	return Substitutor( replacements ).apply( str, start );
+}
+
+inline std::wstring substitute_many( const std::wstring & str,
+									 std::initializer_list<WSubstitutor::replacement_type> replacements,
+									 std::wstring::size_type start = 0 )
+{
+	return WSubstitutor( replacements ).apply( str, start );
+}
+
+} // namespace Tools
+
+#endif
@@ -0,0 +1,473 @@
+/**
+ * Quote aware tokenizers: split_safe() in one pass, and a streaming CSV reader
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    // like split_safe(), but lazy
+ *    for( std::string_view token : Tools::split_safe_view( "hello \"my name is\" Martin" ) ) {
+ *       ...  // 'hello', '"my name is"', 'Martin'
+ *    }
+ *
+ *    std::ifstream in( "huge.csv" );
+ *    Tools::CsvReader csv( in );
+ *    std::vector<std::string> record;
+ *
+ *    while( csv.read( record ) ) {
+ *       ...
+ *    }
+ *
+ * basic_safe_tokenizer:
+ *    Same semantic as the old split_safe(): a separator between two
+ *    unescaped '"' does not split. A quote is escaped by a backslash,
+ *    but not by two of them. The quotes stay in the token. If a quote
+ *    is never closed, it is a normal character.
+ *    Every character is looked at only once, the closing quote is
+ *    searched, when the opening one is reached.
+ *
+ * basic_csv_reader:
+ *    RFC 4180: fields are separated by ',' (configurable) and records by
+ *    CRLF or LF. A quoted field can contain separators, line breaks and
+ *    quotes, written as "". The quotes are removed.
+ *    The stream is read in blocks, so the memory usage does not depend
+ *    on the size of the file. Empty lines are skipped.
+ *    Malformed input is accepted: characters after a closing quote are
+ *    appended to the field, an unterminated quote ends at the end of the file.
+ */
+#ifndef TOOLS_TOKENIZER_H
+#define TOOLS_TOKENIZER_H
+
+#include "char_class.h"
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstddef>
+
+#if __cplusplus >= 201703L
+#  include <string_view>
+#  include <iterator>
+#endif
+
+namespace Tools {
+
+template <class CharT>
+class basic_safe_tokenizer
+{
+public:
+	static const size_t npos = static_cast<size_t>(-1);
+
+private:
+	const CharT *str;
+	size_t len;
+
+	// the separators and the quote
+	basic_char_class<CharT> stop;
+	bool quote_is_sep;
+
+	// start of the next token, npos: no more tokens
+	size_t start = 0;
+
+	// where to continue searching for the next separator
+	size_t pos = 0;
+
+	// a closing quote, that was already found, is not an opening one
+	size_t closing = npos;
+
+	// after an unclosed quote there are no quoted regions any more
+	bool quotes = true;
+
+	static constexpr CharT QUOTE = CharT('"');
+	static constexpr CharT BACKSLASH = CharT('\\');
+
+	static basic_char_class<CharT> make_stop( const CharT *sep, size_t sep_len ) {
+		std::basic_string<CharT> s( sep, sep_len );
+		s += QUOTE;
+		return basic_char_class<CharT>( s );
+	}
+
+public:
+	basic_safe_tokenizer( const CharT *str_, size_t len_, const CharT *sep, size_t sep_len )
+	: str( str_ ),
+	  len( len_ ),
+	  stop( make_stop( sep, sep_len ) ),
+	  quote_is_sep( std::basic_string<CharT>( sep, sep_len ).find( QUOTE ) != std::basic_string<CharT>::npos )
+	{}
+
+	/**
+	 * returns the next token as first position and length.
+	 * There is always at least one token, also for an empty string.
+	 */
+	bool next( size_t & token_start, size_t & token_len ) {
+		if( start == npos ) {
+			return false;
+		}
+
+		for( ;; ) {
+			const size_t p = stop.find_first_of( str, len, pos );
+
+			if( p == stop.npos ) {
+				token_start = start;
+				token_len = len - start;
+				start = npos;
+				return true;
+			}
+
+			const bool is_sep = str[p] != QUOTE || quote_is_sep;
+
+			if( str[p] == QUOTE && quotes && p != closing && !is_escaped( p ) ) {
+				const size_t close = find_closing( p + 1 );
+
+				if( close == npos ) {
+					quotes = false;
+				} else if( !quote_is_sep ) {
+					// nothing inside the quotes can split
+					pos = close + 1;
+					continue;
+				} else {
+					// the quote itself splits, continue at the closing one
+					closing = close;
+					token_start = start;
+					token_len = p - start;
+					start = p + 1;
+					pos = close;
+					return true;
+				}
+			}
+
+			if( !is_sep ) {
+				pos = p + 1;
+				continue;
+			}
+
+			token_start = start;
+			token_len = p - start;
+			start = pos = p + 1;
+			return true;
+		}
+	}
+
+private:
+	// a backslash escapes, two of them not
+	bool is_escaped( size_t p ) const {
+		return p > 0 && str[p - 1] == BACKSLASH && !(p > 1 && str[p - 2] == BACKSLASH);
+	}
+
+	size_t find_closing( size_t p ) const {
+		for( ; p < len; ++p ) {
+			if( str[p] == QUOTE && !is_escaped( p ) ) {
+				return p;
+			}
+		}
+
+		return npos;
+	}
+};
+
+#if __cplusplus >= 201703L
+
+/**
+ * Lazy split_safe(), the tokens are pointing into the original string
+ */
+template <class CharT>
+class basic_split_safe_view
+{
+public:
+	typedef std::basic_string_view<CharT> string_view_type;
+
+private:
+	string_view_type str;
+	string_view_type sep;
+
+public:
+	class iterator
+	{
+		const CharT *base = nullptr;
+		basic_safe_tokenizer<CharT> tokenizer;
+		string_view_type token;
+		bool at_end = true;
+
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef string_view_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const string_view_type* pointer;
+		typedef const string_view_type& reference;
+
+		iterator()
+		: tokenizer( nullptr, 0, nullptr, 0 )
+		{}
+
+		iterator( string_view_type str, string_view_type sep )
+		: base( str.data() ),
+		  tokenizer( str.data(), str.size(), sep.data(), sep.size() ),
+		  at_end( false )
+		{
+			advance();
+		}
+
+		reference operator*() const {
+			return token;
+		}
+
+		pointer operator->() const {
+			return &token;
+		}
+
+		iterator & operator++() {
+			advance();
+			return *this;
+		}
+
+		bool operator==( const iterator & other ) const {
+			if( at_end || other.at_end ) {
+				return at_end == other.at_end;
+			}
+
+			return token.data() == other.token.data() && token.size() == other.token.size();
+		}
+
+		bool operator!=( const iterator & other ) const {
+			return !(*this == other);
+		}
+
+	private:
+		void advance() {
+			size_t start, len;
+
+			if( !tokenizer.next( start, len ) ) {
+				at_end = true;
+				return;
+			}
+
+			token = string_view_type( base + start, len );
+		}
+	};
+
+	typedef iterator const_iterator;
+
+	basic_split_safe_view( string_view_type str_, string_view_type sep_ )
+	: str( str_ ),
+	  sep( sep_ )
+	{}
+
+	iterator begin() const {
+		return iterator( str, sep );
+	}
+
+	iterator end() const {
+		return iterator();
+	}
+};
+
+typedef basic_split_safe_view<char>    split_safe_view_t;
+typedef basic_split_safe_view<wchar_t> wsplit_safe_view_t;
+
+inline split_safe_view_t split_safe_view( std::string_view str, std::string_view sep = " \n\t" )
+{
+	return split_safe_view_t( str, sep );
+}
+
+inline wsplit_safe_view_t split_safe_view( std::wstring_view str, std::wstring_view sep = L" \n\t" )
+{
+	return wsplit_safe_view_t( str, sep );
+}
+
+#endif // __cplusplus >= 201703L
+
+template <class CharT>
+class basic_csv_reader
+{
+public:
+	typedef std::basic_string<CharT> string_type;
+	typedef std::basic_istream<CharT> stream_type;
+
+	static const size_t BUFFER_SIZE = 64 * 1024;
+
+private:
+	stream_type & in;
+	CharT sep;
+
+	std::vector<CharT> buffer;
+	size_t buffer_pos = 0;
+	size_t buffer_len = 0;
+
+	size_t line = 0;
+	bool eof = false;
+
+	static constexpr CharT QUOTE = CharT('"');
+	static constexpr CharT CR = CharT('\r');
+	static constexpr CharT LF = CharT('\n');
+
+	enum class State
+	{
+		FIELD_START,
+		UNQUOTED,
+		QUOTED,
+		QUOTE_IN_QUOTED    // a quote inside a quoted field: closing, or the first of ""
+	};
+
+public:
+	explicit basic_csv_reader( stream_type & in_, CharT sep_ = CharT(',') )
+	: in( in_ ),
+	  sep( sep_ ),
+	  buffer( BUFFER_SIZE )
+	{}
+
+	/**
+	 * reads the next record. The strings of record are reused,
+	 * so reading into the same vector again does not allocate.
+	 * Returns false at the end of the stream.
+	 */
+	bool read( std::vector<string_type> & record );
+
+	// the number of the line, where the last record ended
+	size_t getLine() const {
+		return line;
+	}
+
+private:
+	bool fill() {
+		if( eof ) {
+			return false;
+		}
+
+		const std::streamsize n = in.rdbuf()->sgetn( buffer.data(), static_cast<std::streamsize>( buffer.size() ) );
+
+		if( n <= 0 ) {
+			eof = true;
+			in.setstate( std::ios_base::eofbit );
+			return false;
+		}
+
+		buffer_pos = 0;
+		buffer_len = static_cast<size_t>( n );
+		return true;
+	}
+};
+
+template <class CharT>
+bool basic_csv_reader<CharT>::read( std::vector<string_type> & record )
+{
+	size_t fields = 0;
+	State state = State::FIELD_START;
+	bool empty_line = true;
+
+	auto field = [&]() -> string_type & {
+		if( fields == record.size() ) {
+			record.emplace_back();
+		}
+
+		return record[fields];
+	};
+
+	auto finish = [&]() {
+		record.resize( fields );
+	};
+
+	for( ;; ) {
+		if( buffer_pos == buffer_len && !fill() ) {
+			if( state == State::FIELD_START ) {
+				field().clear();
+			}
+
+			if( empty_line ) {
+				finish();
+				return false;
+			}
+
+			++fields;
+			finish();
+			++line;
+			return true;
+		}
+
+		const CharT *data = buffer.data();
+
+		while( buffer_pos < buffer_len ) {
+			const CharT c = data[buffer_pos++];
+
+			if( state == State::FIELD_START ) {
+				field().clear();
+			}
+
+			switch( state ) {
+			case State::QUOTED:
+				if( c == QUOTE ) {
+					state = State::QUOTE_IN_QUOTED;
+				} else {
+					// copy everything up to the next quote at once
+					const size_t begin = buffer_pos - 1;
+
+					while( buffer_pos < buffer_len && data[buffer_pos] != QUOTE ) {
+						++buffer_pos;
+					}
+
+					for( size_t i = begin; i < buffer_pos; ++i ) {
+						if( data[i] == LF ) {
+							++line;
+						}
+					}
+
+					field().append( data + begin, buffer_pos - begin );
+				}
+				continue;
+
+			case State::QUOTE_IN_QUOTED:
+				if( c == QUOTE ) {
+					field() += QUOTE;
+					state = State::QUOTED;
+					continue;
+				}
+				break;
+
+			case State::FIELD_START:
+				if( c == QUOTE ) {
+					empty_line = false;
+					state = State::QUOTED;
+					continue;
+				}
+				break;
+
+			case State::UNQUOTED:
+				break;
+			}
+
+			// outside of quotes
+			if( c == sep ) {
+				empty_line = false;
+				++fields;
+				state = State::FIELD_START;
+				continue;
+			}
+
+			if( c == LF ) {
+				++line;
+
+				if( empty_line ) {
+					state = State::FIELD_START;
+					continue;
+				}
+
+				++fields;
+				finish();
+				return true;
+			}
+
+			// the CR of CRLF
+			if( c == CR && (buffer_pos < buffer_len || fill()) && buffer[buffer_pos] == LF ) {
+				data = buffer.data();
+				continue;
+			}
+
+			empty_line = false;
+			field() += c;
+			state = State::UNQUOTED;
+		}
+	}
+}
+
+typedef basic_csv_reader<char>    CsvReader;
+typedef basic_csv_reader<wchar_t> WCsvReader;
+
+} // namespace Tools
+
+#endif
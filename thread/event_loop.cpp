@@ -0,0 +1,796 @@
+#include "event_loop.h"
+
+#if defined(TOOLS_USE_THREADS) && defined(__linux__)
+
+#include <CpputilsDebug.h>
+#include <unordered_map>
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#ifdef TOOLS_USE_IO_URING
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#endif
+
+namespace Tools {
+
+namespace {
+
+thread_local EventLoop *current_loop = nullptr;
+
+void throw_errno( const char *what )
+{
+	throw std::system_error( errno, std::generic_category(), what );
+}
+
+int create_eventfd()
+{
+	int fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+	if( fd < 0 ) {
+		throw_errno( "eventfd" );
+	}
+
+	return fd;
+}
+
+void drain_eventfd( int fd )
+{
+	uint64_t value;
+	while( read( fd, &value, sizeof(value) ) > 0 ) {
+	}
+}
+
+void signal_eventfd( int fd )
+{
+	uint64_t one = 1;
+	// EAGAIN: the counter is full, a wakeup is pending anyway
+	[[maybe_unused]] ssize_t res = write( fd, &one, sizeof(one) );
+}
+
+class EpollPoller : public EventLoop::Poller
+{
+	struct FdState
+	{
+		EventLoop::IoWaiter *reader = nullptr;
+		EventLoop::IoWaiter *writer = nullptr;
+		bool registered = false;
+	};
+
+	int epoll_fd;
+	int event_fd;
+	std::unordered_map<int,FdState> fds;
+	std::vector<epoll_event> events;
+
+	// waiters for fds, that epoll does not support (regular files). They are always ready.
+	std::vector<EventLoop::IoWaiter*> immediate;
+
+public:
+	EpollPoller()
+	: epoll_fd( epoll_create1( EPOLL_CLOEXEC ) ),
+	  event_fd( -1 ),
+	  fds(),
+	  events( 128 ),
+	  immediate()
+	{
+		if( epoll_fd < 0 ) {
+			throw_errno( "epoll_create1" );
+		}
+
+		event_fd = create_eventfd();
+
+		epoll_event ev {};
+		ev.events = EPOLLIN;
+		ev.data.fd = event_fd;
+
+		if( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, event_fd, &ev ) != 0 ) {
+			int error = errno;
+			close( event_fd );
+			close( epoll_fd );
+			throw std::system_error( error, std::generic_category(), "epoll_ctl" );
+		}
+	}
+
+	~EpollPoller() {
+		close( event_fd );
+		close( epoll_fd );
+	}
+
+	void watch( int fd, EventLoop::Interest interest, EventLoop::IoWaiter *waiter ) override {
+		FdState & state = fds[fd];
+
+		if( interest == EventLoop::READ ) {
+			state.reader = waiter;
+		} else {
+			state.writer = waiter;
+		}
+
+		arm( fd, state );
+	}
+
+	void wait( int timeout_ms, std::vector<EventLoop::IoWaiter*> & ready ) override {
+		if( !immediate.empty() ) {
+			ready.insert( ready.end(), immediate.begin(), immediate.end() );
+			immediate.clear();
+			timeout_ms = 0;
+		}
+
+		int count = epoll_wait( epoll_fd, events.data(), static_cast<int>(events.size()), timeout_ms );
+
+		for( int i = 0; i < count; ++i ) {
+			const int fd = events[i].data.fd;
+			const uint32_t ev = events[i].events;
+
+			if( fd == event_fd ) {
+				drain_eventfd( event_fd );
+				continue;
+			}
+
+			FdState & state = fds[fd];
+
+			if( state.reader && (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) ) {
+				state.reader->events = ev;
+				ready.push_back( state.reader );
+				state.reader = nullptr;
+			}
+
+			if( state.writer && (ev & (EPOLLOUT | EPOLLHUP | EPOLLERR)) ) {
+				state.writer->events = ev;
+				ready.push_back( state.writer );
+				state.writer = nullptr;
+			}
+
+			// one shot, the other direction has to be rearmed
+			if( state.reader || state.writer ) {
+				arm( fd, state );
+			}
+		}
+
+		if( count == static_cast<int>(events.size()) ) {
+			events.resize( events.size() * 2 );
+		}
+	}
+
+	void wake() override {
+		signal_eventfd( event_fd );
+	}
+
+	EventLoop::Backend getBackend() const override {
+		return EventLoop::Backend::EPOLL;
+	}
+
+private:
+	void arm( int fd, FdState & state ) {
+		epoll_event ev {};
+		ev.events = EPOLLONESHOT;
+		ev.data.fd = fd;
+
+		if( state.reader ) {
+			ev.events |= EPOLLIN | EPOLLRDHUP;
+		}
+
+		if( state.writer ) {
+			ev.events |= EPOLLOUT;
+		}
+
+		// the fd may have been closed and reopened meanwhile,
+		// so the registration state is just a hint
+		int op = state.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+		if( epoll_ctl( epoll_fd, op, fd, &ev ) != 0 ) {
+			if( errno == ENOENT || errno == EEXIST ) {
+				op = (op == EPOLL_CTL_MOD) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+				if( epoll_ctl( epoll_fd, op, fd, &ev ) == 0 ) {
+					state.registered = true;
+					return;
+				}
+			}
+
+			if( errno == EPERM ) {
+				if( state.reader ) {
+					immediate.push_back( state.reader );
+				}
+				if( state.writer ) {
+					immediate.push_back( state.writer );
+				}
+				state = FdState();
+				return;
+			}
+
+			throw_errno( "epoll_ctl" );
+		}
+
+		state.registered = true;
+	}
+};
+
+#ifdef TOOLS_USE_IO_URING
+
+/**
+ * Readiness via IORING_OP_POLL_ADD requests. Uses the raw
+ * system calls, so there is no dependency to liburing.
+ */
+class UringPoller : public EventLoop::Poller
+{
+	static constexpr unsigned ENTRIES = 256;
+
+	// user_data of the eventfd poll request
+	static constexpr uint64_t WAKEUP = 0;
+
+	int ring_fd;
+	int event_fd;
+
+	void  *sq_ptr;
+	size_t sq_size;
+	void  *cq_ptr;
+	size_t cq_size;
+	io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned  sq_entries;
+
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	io_uring_cqe *cqes;
+
+	unsigned to_submit;
+
+public:
+	UringPoller()
+	: ring_fd( -1 ),
+	  event_fd( -1 ),
+	  sq_ptr( MAP_FAILED ),
+	  sq_size( 0 ),
+	  cq_ptr( MAP_FAILED ),
+	  cq_size( 0 ),
+	  sqes( nullptr ),
+	  sqes_size( 0 ),
+	  to_submit( 0 )
+	{
+		io_uring_params p {};
+
+		ring_fd = static_cast<int>( syscall( __NR_io_uring_setup, ENTRIES, &p ) );
+
+		if( ring_fd < 0 ) {
+			throw_errno( "io_uring_setup" );
+		}
+
+		if( !(p.features & IORING_FEAT_EXT_ARG) ) {
+			close( ring_fd );
+			throw std::system_error( ENOTSUP, std::generic_category(), "io_uring without IORING_FEAT_EXT_ARG" );
+		}
+
+		sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+		const bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+
+		if( single_mmap ) {
+			sq_size = cq_size = std::max( sq_size, cq_size );
+		}
+
+		sq_ptr = mmap( nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING );
+
+		if( sq_ptr == MAP_FAILED ) {
+			cleanup_and_throw( "mmap sq ring" );
+		}
+
+		if( single_mmap ) {
+			cq_ptr = sq_ptr;
+		} else {
+			cq_ptr = mmap( nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING );
+
+			if( cq_ptr == MAP_FAILED ) {
+				cleanup_and_throw( "mmap cq ring" );
+			}
+		}
+
+		sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+		void *s = mmap( nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES );
+
+		if( s == MAP_FAILED ) {
+			cleanup_and_throw( "mmap sqes" );
+		}
+
+		sqes = static_cast<io_uring_sqe*>(s);
+
+		char *sq = static_cast<char*>(sq_ptr);
+		sq_head    = reinterpret_cast<unsigned*>( sq + p.sq_off.head );
+		sq_tail    = reinterpret_cast<unsigned*>( sq + p.sq_off.tail );
+		sq_mask    = reinterpret_cast<unsigned*>( sq + p.sq_off.ring_mask );
+		sq_array   = reinterpret_cast<unsigned*>( sq + p.sq_off.array );
+		sq_entries = p.sq_entries;
+
+		char *cq = static_cast<char*>(cq_ptr);
+		cq_head = reinterpret_cast<unsigned*>( cq + p.cq_off.head );
+		cq_tail = reinterpret_cast<unsigned*>( cq + p.cq_off.tail );
+		cq_mask = reinterpret_cast<unsigned*>( cq + p.cq_off.ring_mask );
+		cqes    = reinterpret_cast<io_uring_cqe*>( cq + p.cq_off.cqes );
+
+		event_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+		if( event_fd < 0 ) {
+			cleanup_and_throw( "eventfd" );
+		}
+
+		poll_add( event_fd, POLLIN, WAKEUP );
+	}
+
+	~UringPoller() {
+		cleanup();
+	}
+
+	void watch( int fd, EventLoop::Interest interest, EventLoop::IoWaiter *waiter ) override {
+		poll_add( fd, interest == EventLoop::READ ? (POLLIN | POLLRDHUP) : POLLOUT,
+				  reinterpret_cast<uint64_t>(waiter) );
+	}
+
+	void wait( int timeout_ms, std::vector<EventLoop::IoWaiter*> & ready ) override {
+		const bool have_completions = __atomic_load_n( cq_tail, __ATOMIC_ACQUIRE ) != *cq_head;
+
+		if( to_submit > 0 || (!have_completions && timeout_ms != 0) ) {
+			enter( (have_completions || timeout_ms == 0) ? 0 : 1, timeout_ms );
+		}
+
+		unsigned head = *cq_head;
+		const unsigned tail = __atomic_load_n( cq_tail, __ATOMIC_ACQUIRE );
+		bool rearm_wakeup = false;
+
+		for( ; head != tail; ++head ) {
+			const io_uring_cqe & cqe = cqes[head & *cq_mask];
+
+			if( cqe.user_data == WAKEUP ) {
+				drain_eventfd( event_fd );
+				rearm_wakeup = true;
+				continue;
+			}
+
+			EventLoop::IoWaiter *waiter = reinterpret_cast<EventLoop::IoWaiter*>( cqe.user_data );
+			waiter->events = cqe.res < 0 ? POLLERR : static_cast<uint32_t>(cqe.res);
+			ready.push_back( waiter );
+		}
+
+		__atomic_store_n( cq_head, head, __ATOMIC_RELEASE );
+
+		if( rearm_wakeup ) {
+			poll_add( event_fd, POLLIN, WAKEUP );
+		}
+	}
+
+	void wake() override {
+		signal_eventfd( event_fd );
+	}
+
+	EventLoop::Backend getBackend() const override {
+		return EventLoop::Backend::IO_URING;
+	}
+
+private:
+	void cleanup() {
+		if( event_fd >= 0 ) {
+			close( event_fd );
+		}
+
+		if( sqes ) {
+			munmap( sqes, sqes_size );
+		}
+
+		if( cq_ptr != MAP_FAILED && cq_ptr != sq_ptr ) {
+			munmap( cq_ptr, cq_size );
+		}
+
+		if( sq_ptr != MAP_FAILED ) {
+			munmap( sq_ptr, sq_size );
+		}
+
+		close( ring_fd );
+	}
+
+	[[noreturn]] void cleanup_and_throw( const char *what ) {
+		int error = errno;
+		cleanup();
+		throw std::system_error( error, std::generic_category(), what );
+	}
+
+	int enter( unsigned min_complete, int timeout_ms ) {
+		io_uring_getevents_arg arg {};
+		__kernel_timespec ts {};
+		unsigned flags = IORING_ENTER_EXT_ARG;
+
+		if( min_complete > 0 ) {
+			flags |= IORING_ENTER_GETEVENTS;
+		}
+
+		if( timeout_ms >= 0 ) {
+			ts.tv_sec  = timeout_ms / 1000;
+			ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+			arg.ts = reinterpret_cast<uint64_t>(&ts);
+		}
+
+		int res = static_cast<int>( syscall( __NR_io_uring_enter, ring_fd, to_submit, min_complete,
+											 flags, &arg, sizeof(arg) ) );
+
+		if( res >= 0 ) {
+			to_submit -= std::min( to_submit, static_cast<unsigned>(res) );
+		} else if( errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN ) {
+			throw_errno( "io_uring_enter" );
+		}
+
+		return res;
+	}
+
+	io_uring_sqe *get_sqe() {
+		unsigned tail = *sq_tail;
+
+		if( tail - __atomic_load_n( sq_head, __ATOMIC_ACQUIRE ) >= sq_entries ) {
+			// the queue is full, submit without waiting
+			enter( 0, 0 );
+		}
+
+		const unsigned idx = tail & *sq_mask;
+		io_uring_sqe *sqe = &sqes[idx];
+		memset( sqe, 0, sizeof(*sqe) );
+		sq_array[idx] = idx;
+
+		__atomic_store_n( sq_tail, tail + 1, __ATOMIC_RELEASE );
+		++to_submit;
+
+		return sqe;
+	}
+
+	void poll_add( int fd, uint32_t events, uint64_t user_data ) {
+		io_uring_sqe *sqe = get_sqe();
+
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->fd = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+		events = __swahw32( events );
+#endif
+		sqe->poll32_events = events;
+		sqe->user_data = user_data;
+	}
+};
+
+#endif // TOOLS_USE_IO_URING
+
+} // namespace
+
+/**
+ * The coroutine, that owns a spawned task.
+ * Its frame is registered in EventLoop::roots until it is finished,
+ * so the loop can destroy the suspended ones.
+ */
+struct EventLoop::RootTask
+{
+	struct promise_type
+	{
+		EventLoop & loop;
+
+		promise_type( EventLoop & loop_, task<void> & )
+		: loop( loop_ )
+		{}
+
+		~promise_type() {
+			std::lock_guard<std::mutex> lock( loop.posted_mutex );
+			loop.roots.erase( std::coroutine_handle<promise_type>::from_promise( *this ).address() );
+		}
+
+		RootTask get_return_object() {
+			auto handle = std::coroutine_handle<promise_type>::from_promise( *this );
+
+			std::lock_guard<std::mutex> lock( loop.posted_mutex );
+			loop.roots.insert( handle.address() );
+
+			return RootTask{ handle };
+		}
+
+		std::suspend_always initial_suspend() noexcept {
+			return {};
+		}
+
+		// the frame is freed when the task is finished
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() {}
+
+		void unhandled_exception() {}
+	};
+
+	std::coroutine_handle<promise_type> handle;
+
+	static RootTask run( [[maybe_unused]] EventLoop & loop, task<void> t ) {
+		try {
+			co_await t;
+		} catch( const std::exception & error ) {
+			CPPDEBUG( format( "unhandled exception in spawned task: %s", error.what() ) );
+		} catch( ... ) {
+			CPPDEBUG( "unhandled exception in spawned task" );
+		}
+	}
+};
+
+EventLoop::EventLoop( Backend backend )
+{
+#ifdef TOOLS_USE_IO_URING
+	if( backend == Backend::AUTO || backend == Backend::IO_URING ) {
+		try {
+			poller = std::make_unique<UringPoller>();
+		} catch( const std::system_error & error ) {
+			// not supported by the kernel, or disabled
+			if( backend == Backend::IO_URING ) {
+				throw;
+			}
+		}
+	}
+#else
+	if( backend == Backend::IO_URING ) {
+		throw REPORT_EXCEPTION( "io_uring support is not compiled in, define TOOLS_USE_IO_URING" );
+	}
+#endif
+
+	if( !poller ) {
+		poller = std::make_unique<EpollPoller>();
+	}
+}
+
+EventLoop::~EventLoop()
+{
+	// a job still writes the result into the frame and posts to us
+	{
+		std::unique_lock<std::mutex> lock( offload_mutex );
+		offload_done.wait( lock, [this]() { return offloads == 0; } );
+	}
+
+	std::vector<void*> suspended;
+
+	{
+		std::lock_guard<std::mutex> lock( posted_mutex );
+		suspended.assign( roots.begin(), roots.end() );
+	}
+
+	// the promise is deregistering itself
+	for( void *address : suspended ) {
+		std::coroutine_handle<>::from_address( address ).destroy();
+	}
+}
+
+void EventLoop::begin_offload()
+{
+	std::lock_guard<std::mutex> lock( offload_mutex );
+	++offloads;
+}
+
+void EventLoop::end_offload()
+{
+	// notifying under the lock, the destructor cannot return before we unlocked
+	std::lock_guard<std::mutex> lock( offload_mutex );
+
+	if( --offloads == 0 ) {
+		offload_done.notify_all();
+	}
+}
+
+EventLoop *EventLoop::current()
+{
+	return current_loop;
+}
+
+EventLoop & detail::current_event_loop()
+{
+	if( !current_loop ) {
+		throw REPORT_EXCEPTION( "no EventLoop is running on this thread" );
+	}
+
+	return *current_loop;
+}
+
+void EventLoop::run()
+{
+	run_loop( nullptr );
+	stopping.store( false );
+}
+
+void EventLoop::stop()
+{
+	stopping.store( true );
+	poller->wake();
+}
+
+void EventLoop::spawn( task<void> t )
+{
+	RootTask root = RootTask::run( *this, std::move(t) );
+	post( root.handle );
+}
+
+void EventLoop::post( std::coroutine_handle<> handle )
+{
+	if( current_loop == this ) {
+		ready.push_back( handle );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( posted_mutex );
+		posted.push_back( handle );
+	}
+
+	if( !wake_pending.exchange( true ) ) {
+		poller->wake();
+	}
+}
+
+void EventLoop::take_posted()
+{
+	wake_pending.store( false );
+
+	std::lock_guard<std::mutex> lock( posted_mutex );
+
+	ready.insert( ready.end(), posted.begin(), posted.end() );
+	posted.clear();
+}
+
+void EventLoop::add_timer( Clock::time_point deadline, std::coroutine_handle<> handle )
+{
+	timers.push( Timer{ deadline, timer_sequence++, handle } );
+}
+
+void EventLoop::watch( int fd, Interest interest, IoWaiter *waiter )
+{
+	poller->watch( fd, interest, waiter );
+}
+
+void EventLoop::run_loop( const std::atomic<bool> *done )
+{
+	EventLoop *previous = current_loop;
+	current_loop = this;
+
+	auto finished = [this, done]() {
+		return done ? done->load() : stopping.load();
+	};
+
+	while( !finished() ) {
+		take_posted();
+
+		// coroutines, that are getting ready meanwhile are run in the next round,
+		// so timers and I/O are not starved
+		for( size_t count = ready.size(); count > 0 && !ready.empty(); --count ) {
+			std::coroutine_handle<> handle = ready.front();
+			ready.pop_front();
+			handle.resume();
+		}
+
+		if( finished() ) {
+			break;
+		}
+
+		const Clock::time_point now = Clock::now();
+
+		while( !timers.empty() && timers.top().deadline <= now ) {
+			ready.push_back( timers.top().handle );
+			timers.pop();
+		}
+
+		int timeout_ms = -1;
+
+		if( !ready.empty() ) {
+			timeout_ms = 0;
+		} else if( !timers.empty() ) {
+			timeout_ms = static_cast<int>( std::min<int64_t>( INT32_MAX,
+				std::chrono::ceil<std::chrono::milliseconds>( timers.top().deadline - now ).count() ) );
+		}
+
+		io_ready.clear();
+		poller->wait( timeout_ms, io_ready );
+
+		for( IoWaiter *waiter : io_ready ) {
+			ready.push_back( waiter->handle );
+		}
+	}
+
+	current_loop = previous;
+}
+
+task<ssize_t> async_read( int fd, void *buffer, size_t len )
+{
+	while( true ) {
+		// optimistic, mostly there is something to read
+		ssize_t res = read( fd, buffer, len );
+
+		if( res >= 0 ) {
+			co_return res;
+		}
+
+		if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+			co_await async_readable( fd );
+		} else if( errno != EINTR ) {
+			throw_errno( "read" );
+		}
+	}
+}
+
+task<size_t> async_write( int fd, const void *buffer, size_t len )
+{
+	const char *data = static_cast<const char*>(buffer);
+	size_t written = 0;
+
+	while( written < len ) {
+		ssize_t res = write( fd, data + written, len - written );
+
+		if( res >= 0 ) {
+			written += res;
+			continue;
+		}
+
+		if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+			co_await async_writable( fd );
+		} else if( errno != EINTR ) {
+			throw_errno( "write" );
+		}
+	}
+
+	co_return written;
+}
+
+IoScheduler::IoScheduler( int threads, EventLoop::Backend backend )
+{
+	if( threads <= 0 ) {
+		threads = Thread::processors();
+	}
+
+	for( int i = 0; i < threads; ++i ) {
+		workers.push_back( std::make_unique<Worker>( backend ) );
+	}
+
+	for( size_t i = 0; i < workers.size(); ++i ) {
+		Thread::Options options;
+		options.name = format( "io-loop-%d", i );
+		workers[i]->start( options );
+	}
+}
+
+IoScheduler::~IoScheduler()
+{
+	shutdown();
+}
+
+void IoScheduler::spawn( task<void> t )
+{
+	if( workers.empty() ) {
+		throw REPORT_EXCEPTION( "IoScheduler is already shut down" );
+	}
+
+	const size_t idx = next.fetch_add( 1, std::memory_order_relaxed ) % workers.size();
+	workers[idx]->loop.spawn( std::move(t) );
+}
+
+void IoScheduler::shutdown()
+{
+	for( auto & worker : workers ) {
+		worker->loop.stop();
+	}
+
+	for( auto & worker : workers ) {
+		worker->wait();
+	}
+
+	workers.clear();
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS && __linux__
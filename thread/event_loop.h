@@ -0,0 +1,430 @@
+/**
+ * Coroutine event loop with timers and asynchronous I/O
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::task<void> echo( int fd ) {
+ *       char buffer[1024];
+ *       while( true ) {
+ *          ssize_t len = co_await Tools::async_read( fd, buffer, sizeof(buffer) );
+ *          if( len <= 0 ) {
+ *             co_return;
+ *          }
+ *          co_await Tools::async_write( fd, buffer, len );
+ *       }
+ *    }
+ *
+ *    Tools::IoScheduler scheduler;           // one EventLoop per processor
+ *    scheduler.spawn( echo( fd ) );
+ *
+ *    // or on the calling thread
+ *    Tools::EventLoop loop;
+ *    loop.run_until_complete( echo( fd ) );
+ *
+ * CPU bound work can be moved to a ThreadPool, the coroutine continues
+ * on its EventLoop afterwards:
+ *    int res = co_await Tools::offload( pool, []() { return crunch(); } );
+ *
+ * The file descriptors have to be in non blocking mode.
+ * The readiness is detected with epoll. If compiled with
+ * TOOLS_USE_IO_URING and the kernel supports io_uring (5.11+),
+ * io_uring poll requests are used instead.
+ */
+#ifndef TOOLS_EVENT_LOOP_H
+#define TOOLS_EVENT_LOOP_H
+
+#include "thread_pool.h"
+#include "task.h"
+
+#if defined(TOOLS_USE_THREADS) && defined(__linux__)
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <unordered_set>
+#include <sys/types.h>
+
+namespace Tools {
+
+class EventLoop
+{
+public:
+	enum class Backend
+	{
+		AUTO,
+		EPOLL,
+		IO_URING
+	};
+
+	enum Interest : uint32_t
+	{
+		READ  = 1,
+		WRITE = 2
+	};
+
+	// a coroutine waiting for a file descriptor
+	struct IoWaiter
+	{
+		std::coroutine_handle<> handle;
+		uint32_t events = 0;    // the poll events, that woke it up
+	};
+
+	class Poller
+	{
+	public:
+		virtual ~Poller() {}
+
+		// one shot: the waiter is woken up once
+		virtual void watch( int fd, Interest interest, IoWaiter *waiter ) = 0;
+
+		// timeout_ms < 0: infinite
+		virtual void wait( int timeout_ms, std::vector<IoWaiter*> & ready ) = 0;
+
+		// interrupts wait(), can be called from any thread
+		virtual void wake() = 0;
+
+		virtual Backend getBackend() const = 0;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+protected:
+	struct Timer
+	{
+		Clock::time_point deadline;
+		uint64_t sequence;
+		std::coroutine_handle<> handle;
+
+		bool operator>( const Timer & other ) const {
+			if( deadline != other.deadline ) {
+				return deadline > other.deadline;
+			}
+			return sequence > other.sequence;
+		}
+	};
+
+	std::unique_ptr<Poller> poller;
+
+	// only touched by the loop's thread
+	std::deque<std::coroutine_handle<>> ready;
+	std::priority_queue<Timer,std::vector<Timer>,std::greater<Timer>> timers;
+	uint64_t timer_sequence = 0;
+	std::vector<IoWaiter*> io_ready;
+
+	// posted from other threads
+	std::mutex posted_mutex;
+	std::vector<std::coroutine_handle<>> posted;
+	std::atomic<bool> wake_pending = false;
+
+	// the coroutine frames of the spawned tasks, guarded by posted_mutex
+	struct RootTask;
+	std::unordered_set<void*> roots;
+
+	std::atomic<bool> stopping = false;
+
+	// running offload() jobs, that are going to post to this loop
+	std::mutex offload_mutex;
+	std::condition_variable offload_done;
+	size_t offloads = 0;
+
+public:
+	explicit EventLoop( Backend backend = Backend::AUTO );
+
+	/**
+	 * Waits for the running offload() jobs of this loop,
+	 * then destroys the tasks, that are still suspended.
+	 */
+	~EventLoop();
+
+	EventLoop( const EventLoop & other ) = delete;
+	EventLoop & operator=( const EventLoop & other ) = delete;
+
+	Backend getBackend() const {
+		return poller->getBackend();
+	}
+
+	// the loop, that is running on the calling thread
+	static EventLoop *current();
+
+	/**
+	 * Runs the loop until stop() is called.
+	 */
+	void run();
+
+	// can be called from any thread
+	void stop();
+
+	/**
+	 * Runs the loop on the calling thread until the task is done.
+	 * Returns the result of the task, or rethrows its exception.
+	 * stop() has no effect on this.
+	 */
+	template <class T>
+	T run_until_complete( task<T> t ) {
+		std::atomic<bool> done = false;
+		spawn( notify_when_done( t, done ) );
+		run_loop( &done );
+		return t.result();
+	}
+
+	/**
+	 * Starts the task on this loop. The loop owns the task
+	 * from now on. Can be called from any thread.
+	 */
+	void spawn( task<void> t );
+
+	// resumes the coroutine on the loop's thread. Can be called from any thread.
+	void post( std::coroutine_handle<> handle );
+
+	/**
+	 * Used by offload(): the destructor waits until each begin_offload()
+	 * is matched by an end_offload(), so a job never touches a destroyed
+	 * loop or coroutine frame. Can be called from any thread.
+	 */
+	void begin_offload();
+	void end_offload();
+
+	// these are only allowed on the loop's thread
+	void add_timer( Clock::time_point deadline, std::coroutine_handle<> handle );
+	void watch( int fd, Interest interest, IoWaiter *waiter );
+
+	/**
+	 * co_await loop.schedule() continues the coroutine on this loop
+	 */
+	auto schedule() {
+		struct awaiter
+		{
+			EventLoop & loop;
+
+			bool await_ready() const noexcept {
+				return false;
+			}
+
+			void await_suspend( std::coroutine_handle<> h ) {
+				loop.post( h );
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		return awaiter{ *this };
+	}
+
+protected:
+	void run_loop( const std::atomic<bool> *done );
+	void take_posted();
+
+	template <class T>
+	static task<void> notify_when_done( task<T> & t, std::atomic<bool> & done ) {
+		co_await t.when_ready();
+		done.store( true );
+	}
+};
+
+namespace detail {
+
+// throws, if no loop is running on the calling thread
+EventLoop & current_event_loop();
+
+struct sleep_awaiter
+{
+	EventLoop::Clock::time_point deadline;
+
+	bool await_ready() const {
+		return deadline <= EventLoop::Clock::now();
+	}
+
+	void await_suspend( std::coroutine_handle<> h ) {
+		current_event_loop().add_timer( deadline, h );
+	}
+
+	void await_resume() noexcept {}
+};
+
+struct io_awaiter
+{
+	int fd;
+	EventLoop::Interest interest;
+	EventLoop::IoWaiter waiter;
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend( std::coroutine_handle<> h ) {
+		waiter.handle = h;
+		current_event_loop().watch( fd, interest, &waiter );
+	}
+
+	// returns the poll events
+	uint32_t await_resume() noexcept {
+		return waiter.events;
+	}
+};
+
+} // namespace detail
+
+template <class Rep, class Period>
+detail::sleep_awaiter async_sleep( const std::chrono::duration<Rep,Period> & duration )
+{
+	return detail::sleep_awaiter{ EventLoop::Clock::now() +
+		std::chrono::duration_cast<EventLoop::Clock::duration>( duration ) };
+}
+
+inline detail::sleep_awaiter async_sleep_until( EventLoop::Clock::time_point deadline )
+{
+	return detail::sleep_awaiter{ deadline };
+}
+
+inline detail::io_awaiter async_readable( int fd )
+{
+	return detail::io_awaiter{ fd, EventLoop::READ, {} };
+}
+
+inline detail::io_awaiter async_writable( int fd )
+{
+	return detail::io_awaiter{ fd, EventLoop::WRITE, {} };
+}
+
+/**
+ * Reads at most len bytes, waits until at least one byte is available.
+ * Returns 0 at end of file, throws std::system_error on errors.
+ */
+task<ssize_t> async_read( int fd, void *buffer, size_t len );
+
+// writes all bytes, throws std::system_error on errors
+task<size_t> async_write( int fd, const void *buffer, size_t len );
+
+/**
+ * Runs func() on the thread pool, and continues the coroutine on
+ * the current EventLoop, when it is done. Exceptions are rethrown.
+ */
+template <class Func>
+auto offload( ThreadPool & pool, Func func )
+{
+	typedef std::invoke_result_t<Func> T;
+
+	struct awaiter
+	{
+		ThreadPool & pool;
+		Func func;
+		std::optional<std::conditional_t<std::is_void<T>::value,bool,T>> value;
+		std::exception_ptr error;
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		void await_suspend( std::coroutine_handle<> h ) {
+			EventLoop *loop = EventLoop::current();
+
+			if( loop ) {
+				loop->begin_offload();
+			}
+
+			try {
+				submit( h, loop );
+			} catch( ... ) {
+				if( loop ) {
+					loop->end_offload();
+				}
+				throw;
+			}
+		}
+
+		void submit( std::coroutine_handle<> h, EventLoop *loop ) {
+			pool.submit( [this, h, loop]() {
+				try {
+					if constexpr( std::is_void<T>::value ) {
+						func();
+					} else {
+						value.emplace( func() );
+					}
+				} catch( ... ) {
+					error = std::current_exception();
+				}
+
+				if( loop ) {
+					// the last access to the loop and the frame
+					loop->post( h );
+					loop->end_offload();
+				} else {
+					h.resume();
+				}
+			});
+		}
+
+		T await_resume() {
+			if( error ) {
+				std::rethrow_exception( error );
+			}
+
+			if constexpr( !std::is_void<T>::value ) {
+				return std::move( *value );
+			}
+		}
+	};
+
+	return awaiter{ pool, std::move(func), {}, {} };
+}
+
+/**
+ * Runs one EventLoop per worker thread. Spawned tasks
+ * are distributed round robin over the loops.
+ */
+class IoScheduler
+{
+	class Worker : public Thread
+	{
+	public:
+		EventLoop loop;
+
+		explicit Worker( EventLoop::Backend backend )
+		: loop( backend )
+		{}
+
+		void run() override {
+			loop.run();
+		}
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic<size_t> next = 0;
+
+public:
+	// threads <= 0: one loop per processor
+	explicit IoScheduler( int threads = 0, EventLoop::Backend backend = EventLoop::Backend::AUTO );
+
+	IoScheduler( const IoScheduler & other ) = delete;
+	IoScheduler & operator=( const IoScheduler & other ) = delete;
+
+	// calls shutdown()
+	~IoScheduler();
+
+	size_t size() const {
+		return workers.size();
+	}
+
+	EventLoop & getLoop( size_t idx ) {
+		return workers.at( idx )->loop;
+	}
+
+	void spawn( task<void> t );
+
+	/**
+	 * Stops all loops and joins the threads. Waits for the running
+	 * offload() jobs, then the tasks, that are still suspended are destroyed.
+	 */
+	void shutdown();
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS && __linux__
+
+#endif
@@ -0,0 +1,344 @@
+#include "mutex.h"
+#include <algorithm>
+
+#ifdef TOOLS_USE_THREADS
+
+namespace Tools {
+
+namespace detail {
+
+bool spinning_makes_sense()
+{
+	// on a single processor the holder cannot run while we are spinning
+	static const bool multi_core = Thread::processors() > 1;
+	return multi_core;
+}
+
+bool spin_while_equal( const std::atomic<uint32_t> & value, uint32_t old )
+{
+	if( !spinning_makes_sense() ) {
+		return false;
+	}
+
+	for( int32_t i = 0; i < AdaptiveMutex::max_spin; ++i ) {
+		if( value.load( std::memory_order_relaxed ) != old ) {
+			return true;
+		}
+		cpu_relax();
+	}
+
+	return false;
+}
+
+} // namespace detail
+
+namespace {
+
+using detail::spinning_makes_sense;
+using detail::spin_while_equal;
+
+std::atomic<unsigned> next_thread_index = 0;
+thread_local unsigned thread_index = next_thread_index.fetch_add( 1, std::memory_order_relaxed );
+
+} // namespace
+
+void AdaptiveMutex::lock_contended()
+{
+	if( spinning_makes_sense() ) {
+		const int32_t estimate = spin_estimate.load( std::memory_order_relaxed );
+		const int32_t limit = std::min( max_spin, estimate * 2 + 10 );
+		int32_t count = 0;
+		bool acquired = false;
+
+		for( ; count < limit; ++count ) {
+			uint32_t expected = UNLOCKED;
+
+			if( state.load( std::memory_order_relaxed ) == UNLOCKED &&
+				state.compare_exchange_strong( expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+				acquired = true;
+				break;
+			}
+			cpu_relax();
+		}
+
+		spin_estimate.store( estimate + (count - estimate) / 8, std::memory_order_relaxed );
+
+		if( acquired ) {
+			return;
+		}
+	}
+
+	// we are leaving the state at LOCKED_WITH_WAITERS, even if we are
+	// the last waiter. This costs a needless wakeup call at most.
+	uint32_t s = state.exchange( LOCKED_WITH_WAITERS, std::memory_order_acquire );
+
+	while( s != UNLOCKED ) {
+		state.wait( LOCKED_WITH_WAITERS, std::memory_order_relaxed );
+		s = state.exchange( LOCKED_WITH_WAITERS, std::memory_order_acquire );
+	}
+}
+
+void SharedMutex::lock()
+{
+	uint32_t s = 0;
+
+	if( state.compare_exchange_strong( s, WRITER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+#ifdef TOOLS_MUTEX_PROFILING
+		profile.acquired( 0 );
+#endif
+		return;
+	}
+
+#ifdef TOOLS_MUTEX_PROFILING
+	uint64_t wait_start = MutexProfile::now();
+#endif
+
+	// from now on no new readers are admitted
+	state.fetch_add( WAITING_WRITER, std::memory_order_relaxed );
+
+	while( true ) {
+		s = state.load( std::memory_order_relaxed );
+
+		if( (s & (WRITER | READER_MASK)) == 0 ) {
+			if( state.compare_exchange_weak( s, s - WAITING_WRITER + WRITER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+#ifdef TOOLS_MUTEX_PROFILING
+				profile.acquired( wait_start );
+#endif
+				return;
+			}
+			continue;
+		}
+
+		wait( s );
+	}
+}
+
+bool SharedMutex::try_lock()
+{
+	uint32_t s = state.load( std::memory_order_relaxed );
+
+	if( (s & (WRITER | READER_MASK)) != 0 ||
+		!state.compare_exchange_strong( s, s | WRITER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+		return false;
+	}
+
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.acquired( 0 );
+#endif
+	return true;
+}
+
+void SharedMutex::unlock()
+{
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.released();
+#endif
+	state.fetch_sub( WRITER, std::memory_order_seq_cst );
+	wake();
+}
+
+bool SharedMutex::try_lock_shared()
+{
+	uint32_t s = state.load( std::memory_order_relaxed );
+
+	if( (s & (WRITER | WAITING_MASK)) != 0 ||
+		!state.compare_exchange_strong( s, s + READER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+		return false;
+	}
+
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.acquired( 0, false );
+#endif
+	return true;
+}
+
+void SharedMutex::lock_shared_contended()
+{
+	while( true ) {
+		uint32_t s = state.load( std::memory_order_relaxed );
+
+		if( (s & (WRITER | WAITING_MASK)) != 0 ) {
+			wait( s );
+			continue;
+		}
+
+		if( state.compare_exchange_weak( s, s + READER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+			return;
+		}
+	}
+}
+
+void SharedMutex::wait( uint32_t s )
+{
+	if( spin_while_equal( state, s ) ) {
+		return;
+	}
+
+	// the seq_cst ordering pairs with the sleepers check in wake()
+	sleepers.fetch_add( 1, std::memory_order_seq_cst );
+	state.wait( s, std::memory_order_seq_cst );
+	sleepers.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+void SharedMutex::wake()
+{
+	if( sleepers.load( std::memory_order_seq_cst ) != 0 ) {
+		state.notify_all();
+	}
+}
+
+DistributedSharedMutex::DistributedSharedMutex( unsigned slots_, [[maybe_unused]] const char *name )
+: slot_count( slots_ > 0 ? slots_ : std::max( 1, Thread::processors() ) ),
+  slots( new Slot[slot_count] )
+#ifdef TOOLS_MUTEX_PROFILING
+  , profile( name )
+#endif
+{
+}
+
+DistributedSharedMutex::Slot & DistributedSharedMutex::my_slot()
+{
+	return slots[thread_index % slot_count];
+}
+
+void DistributedSharedMutex::lock()
+{
+#ifdef TOOLS_MUTEX_PROFILING
+	uint64_t wait_start = MutexProfile::now();
+	bool contended = false;
+#endif
+
+	// waiting writers are keeping new readers out
+	writer.fetch_add( 1, std::memory_order_seq_cst );
+
+	if( !writer_mutex.try_lock() ) {
+		writer_mutex.lock();
+#ifdef TOOLS_MUTEX_PROFILING
+		contended = true;
+#endif
+	}
+
+	for( unsigned i = 0; i < slot_count; ++i ) {
+		std::atomic<uint32_t> & readers = slots[i].readers;
+		uint32_t r;
+
+		while( (r = readers.load( std::memory_order_seq_cst )) != 0 ) {
+#ifdef TOOLS_MUTEX_PROFILING
+			contended = true;
+#endif
+			if( !spin_while_equal( readers, r ) ) {
+				readers.wait( r, std::memory_order_seq_cst );
+			}
+		}
+	}
+
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.acquired( contended ? wait_start : 0 );
+#endif
+}
+
+bool DistributedSharedMutex::try_lock()
+{
+	if( !writer_mutex.try_lock() ) {
+		return false;
+	}
+
+	writer.fetch_add( 1, std::memory_order_seq_cst );
+
+	for( unsigned i = 0; i < slot_count; ++i ) {
+		if( slots[i].readers.load( std::memory_order_seq_cst ) != 0 ) {
+			writer.fetch_sub( 1, std::memory_order_seq_cst );
+			writer.notify_all();
+			writer_mutex.unlock();
+			return false;
+		}
+	}
+
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.acquired( 0 );
+#endif
+	return true;
+}
+
+void DistributedSharedMutex::unlock()
+{
+#ifdef TOOLS_MUTEX_PROFILING
+	profile.released();
+#endif
+	writer.fetch_sub( 1, std::memory_order_seq_cst );
+	writer.notify_all();
+	writer_mutex.unlock();
+}
+
+void DistributedSharedMutex::lock_shared()
+{
+	Slot & slot = my_slot();
+
+#ifdef TOOLS_MUTEX_PROFILING
+	uint64_t wait_start = 0;
+#endif
+
+	while( true ) {
+		slot.readers.fetch_add( 1, std::memory_order_seq_cst );
+
+		if( writer.load( std::memory_order_seq_cst ) == 0 ) {
+#ifdef TOOLS_MUTEX_PROFILING
+			profile.acquired( wait_start, false );
+#endif
+			return;
+		}
+
+#ifdef TOOLS_MUTEX_PROFILING
+		if( !wait_start ) {
+			wait_start = MutexProfile::now();
+		}
+#endif
+
+		// back off, until the writers are done
+		if( slot.readers.fetch_sub( 1, std::memory_order_seq_cst ) == 1 ) {
+			slot.readers.notify_all();
+		}
+
+		uint32_t w;
+
+		while( (w = writer.load( std::memory_order_acquire )) != 0 ) {
+			if( !spin_while_equal( writer, w ) ) {
+				writer.wait( w, std::memory_order_acquire );
+			}
+		}
+	}
+}
+
+bool DistributedSharedMutex::try_lock_shared()
+{
+	Slot & slot = my_slot();
+
+	slot.readers.fetch_add( 1, std::memory_order_seq_cst );
+
+	if( writer.load( std::memory_order_seq_cst ) == 0 ) {
+#ifdef TOOLS_MUTEX_PROFILING
+		profile.acquired( 0, false );
+#endif
+		return true;
+	}
+
+	if( slot.readers.fetch_sub( 1, std::memory_order_seq_cst ) == 1 ) {
+		slot.readers.notify_all();
+	}
+
+	return false;
+}
+
+void DistributedSharedMutex::unlock_shared()
+{
+	Slot & slot = my_slot();
+
+	if( slot.readers.fetch_sub( 1, std::memory_order_seq_cst ) == 1 &&
+		writer.load( std::memory_order_seq_cst ) != 0 ) {
+		slot.readers.notify_all();
+	}
+}
+
+} // namespace Tools
+
+#endif
@@ -0,0 +1,278 @@
+/**
+ * Adaptive mutexes, that are spinning a short time
+ * before the thread is parked on a futex.
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::AdaptiveMutex mutex;
+ *    {
+ *       Thread::MutexLock lock( mutex );
+ *       ...
+ *    }
+ *
+ *    Tools::SharedMutex config_mutex;
+ *    {
+ *       Thread::SharedMutexLock lock( config_mutex );  // reader
+ *       ...
+ *    }
+ *    {
+ *       Thread::MutexLock lock( config_mutex );        // writer
+ *       ...
+ *    }
+ *
+ * All types are also usable with std::lock_guard, std::unique_lock
+ * and std::shared_lock.
+ */
+#ifndef TOOLS_MUTEX_H
+#define TOOLS_MUTEX_H
+
+#include "thread.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "mutex_profiler.h"
+
+namespace Tools {
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile( "yield" );
+#endif
+}
+
+namespace detail {
+
+bool spinning_makes_sense();
+
+// spins a short time, returns true if the value changed meanwhile
+bool spin_while_equal( const std::atomic<uint32_t> & value, uint32_t old );
+
+} // namespace detail
+
+/**
+ * Mutex, that spins up to max_spin rounds, before it is going to sleep.
+ * Like glibc's PTHREAD_MUTEX_ADAPTIVE_NP the number of rounds adapts
+ * to the number, that was required for the last acquisitions.
+ * On single processor machines it never spins.
+ */
+class AdaptiveMutex
+{
+	enum : uint32_t {
+		UNLOCKED = 0,
+		LOCKED = 1,
+		LOCKED_WITH_WAITERS = 2
+	};
+
+	std::atomic<uint32_t> state = UNLOCKED;
+	std::atomic<int32_t>  spin_estimate = 0;
+
+public:
+#ifdef TOOLS_MUTEX_PROFILING
+	MutexProfile profile;
+#endif
+
+	static constexpr int32_t max_spin = 100;
+
+	AdaptiveMutex() = default;
+
+	// the name is used by the mutex profiler only
+	explicit AdaptiveMutex( [[maybe_unused]] const char *name )
+#ifdef TOOLS_MUTEX_PROFILING
+	: profile( name )
+#endif
+	{}
+
+	AdaptiveMutex( const AdaptiveMutex & other ) = delete;
+	AdaptiveMutex & operator=( const AdaptiveMutex & other ) = delete;
+
+	void lock() {
+		uint32_t expected = UNLOCKED;
+
+		if( state.compare_exchange_strong( expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+#ifdef TOOLS_MUTEX_PROFILING
+			profile.acquired( 0 );
+#endif
+			return;
+		}
+
+#ifdef TOOLS_MUTEX_PROFILING
+		uint64_t wait_start = MutexProfile::now();
+		lock_contended();
+		profile.acquired( wait_start );
+#else
+		lock_contended();
+#endif
+	}
+
+	bool try_lock() {
+		uint32_t expected = UNLOCKED;
+		bool res = state.compare_exchange_strong( expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed );
+
+#ifdef TOOLS_MUTEX_PROFILING
+		if( res ) {
+			profile.acquired( 0 );
+		}
+#endif
+		return res;
+	}
+
+	void unlock() {
+#ifdef TOOLS_MUTEX_PROFILING
+		profile.released();
+#endif
+		if( state.exchange( UNLOCKED, std::memory_order_release ) == LOCKED_WITH_WAITERS ) {
+			state.notify_one();
+		}
+	}
+
+	bool locked() const {
+		return state.load( std::memory_order_relaxed ) != UNLOCKED;
+	}
+
+private:
+	void lock_contended();
+};
+
+/**
+ * Reader/writer mutex with writer preference: as soon as a writer
+ * is waiting, no new readers are admitted. So writers cannot starve,
+ * even if the readers are holding the lock all the time.
+ *
+ * All state is kept in one word. So every reader is still writing
+ * to the same cache line. Use DistributedSharedMutex, if there are
+ * many concurrent readers and very few writers.
+ */
+class SharedMutex
+{
+	// bits  0..15: active readers
+	// bits 16..30: waiting writers
+	// bit  31:     writer active
+	static constexpr uint32_t READER         = 1;
+	static constexpr uint32_t READER_MASK    = 0xffff;
+	static constexpr uint32_t WAITING_WRITER = 1 << 16;
+	static constexpr uint32_t WAITING_MASK   = 0x7fff << 16;
+	static constexpr uint32_t WRITER         = 1u << 31;
+
+	std::atomic<uint32_t> state = 0;
+	std::atomic<uint32_t> sleepers = 0;
+
+public:
+#ifdef TOOLS_MUTEX_PROFILING
+	MutexProfile profile;
+#endif
+
+	SharedMutex() = default;
+
+	// the name is used by the mutex profiler only
+	explicit SharedMutex( [[maybe_unused]] const char *name )
+#ifdef TOOLS_MUTEX_PROFILING
+	: profile( name )
+#endif
+	{}
+
+	SharedMutex( const SharedMutex & other ) = delete;
+	SharedMutex & operator=( const SharedMutex & other ) = delete;
+
+	void lock();
+	bool try_lock();
+	void unlock();
+
+	void lock_shared() {
+		uint32_t s = state.load( std::memory_order_relaxed );
+
+		if( (s & (WRITER | WAITING_MASK)) == 0 &&
+			state.compare_exchange_strong( s, s + READER, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+#ifdef TOOLS_MUTEX_PROFILING
+			profile.acquired( 0, false );
+#endif
+			return;
+		}
+
+#ifdef TOOLS_MUTEX_PROFILING
+		uint64_t wait_start = MutexProfile::now();
+		lock_shared_contended();
+		profile.acquired( wait_start, false );
+#else
+		lock_shared_contended();
+#endif
+	}
+
+	bool try_lock_shared();
+
+	void unlock_shared() {
+		uint32_t s = state.fetch_sub( READER, std::memory_order_seq_cst ) - READER;
+
+		// the last reader is leaving, and a writer is waiting
+		if( (s & READER_MASK) == 0 && (s & WAITING_MASK) != 0 ) {
+			wake();
+		}
+	}
+
+private:
+	void lock_shared_contended();
+	void wait( uint32_t s );
+	void wake();
+};
+
+/**
+ * Reader scalable reader/writer mutex with writer preference.
+ *
+ * Every thread is assigned to one of the per processor reader slots.
+ * Each slot is on its own cache line, so readers on different cores
+ * are not bouncing a shared counter. A writer has to wait until all
+ * the slots are empty, so acquiring the write lock is expensive.
+ */
+class DistributedSharedMutex
+{
+	struct alignas(64) Slot
+	{
+		std::atomic<uint32_t> readers = 0;
+	};
+
+	const unsigned            slot_count;
+	std::unique_ptr<Slot[]>   slots;
+
+	// serializes the writers, they are rare
+	std::mutex                writer_mutex;
+
+	alignas(64) std::atomic<uint32_t> writer = 0;
+
+public:
+#ifdef TOOLS_MUTEX_PROFILING
+	MutexProfile profile;
+#endif
+
+	/**
+	 * slots == 0: one slot per processor
+	 * the name is used by the mutex profiler only
+	 */
+	explicit DistributedSharedMutex( unsigned slots = 0, const char *name = nullptr );
+
+	DistributedSharedMutex( const DistributedSharedMutex & other ) = delete;
+	DistributedSharedMutex & operator=( const DistributedSharedMutex & other ) = delete;
+
+	void lock();
+	bool try_lock();
+	void unlock();
+
+	void lock_shared();
+	bool try_lock_shared();
+	void unlock_shared();
+
+private:
+	Slot & my_slot();
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
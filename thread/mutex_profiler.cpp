@@ -0,0 +1,289 @@
+#include "mutex_profiler.h"
+#include "../../tools_config.h"
+#include <CpputilsDebug.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <mutex>
+
+namespace Tools {
+
+#ifdef TOOLS_MUTEX_PROFILING
+
+namespace {
+
+struct Registry
+{
+	std::mutex mutex;
+	MutexProfile *head = nullptr;
+
+	// statistics of already destroyed mutexes
+	std::map<std::string,MutexProfiler::Entry> retired;
+};
+
+Registry & registry()
+{
+	// never destroyed, global mutexes may be destroyed later
+	static Registry *r = new Registry();
+	return *r;
+}
+
+void update_max( std::atomic<uint64_t> & max, uint64_t value )
+{
+	uint64_t current = max.load( std::memory_order_relaxed );
+
+	while( value > current &&
+		   !max.compare_exchange_weak( current, value, std::memory_order_relaxed ) ) {
+	}
+}
+
+void add_entry( MutexProfiler::Entry & sum, const MutexProfiler::Entry & e )
+{
+	sum.mutexes       += e.mutexes;
+	sum.acquisitions  += e.acquisitions;
+	sum.contended     += e.contended;
+	sum.total_wait_ns += e.total_wait_ns;
+	sum.max_wait_ns    = std::max( sum.max_wait_ns, e.max_wait_ns );
+	sum.max_hold_ns    = std::max( sum.max_hold_ns, e.max_hold_ns );
+}
+
+} // namespace
+
+MutexProfile::MutexProfile( const char *name_ )
+: name( name_ ),
+  file( nullptr ),
+  line( 0 ),
+  acquisitions( 0 ),
+  contended( 0 ),
+  total_wait_ns( 0 ),
+  max_wait_ns( 0 ),
+  max_hold_ns( 0 ),
+  acquired_at( 0 ),
+  prev( nullptr ),
+  next( nullptr )
+{
+	Registry & r = registry();
+	std::lock_guard<std::mutex> lock( r.mutex );
+
+	next = r.head;
+
+	if( next ) {
+		next->prev = this;
+	}
+
+	r.head = this;
+}
+
+MutexProfile::~MutexProfile()
+{
+	Registry & r = registry();
+	std::lock_guard<std::mutex> lock( r.mutex );
+
+	if( acquisitions.load( std::memory_order_relaxed ) > 0 ) {
+		MutexProfiler::Entry e = getEntry();
+		MutexProfiler::Entry & sum = r.retired[e.name];
+		sum.name = e.name;
+		add_entry( sum, e );
+	}
+
+	if( prev ) {
+		prev->next = next;
+	} else {
+		r.head = next;
+	}
+
+	if( next ) {
+		next->prev = prev;
+	}
+}
+
+uint64_t MutexProfile::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void MutexProfile::acquired( uint64_t wait_start, bool exclusive )
+{
+	acquisitions.fetch_add( 1, std::memory_order_relaxed );
+
+	if( !wait_start && !exclusive ) {
+		return;
+	}
+
+	const uint64_t t = now();
+
+	if( wait_start ) {
+		const uint64_t wait = t - wait_start;
+
+		contended.fetch_add( 1, std::memory_order_relaxed );
+		total_wait_ns.fetch_add( wait, std::memory_order_relaxed );
+		update_max( max_wait_ns, wait );
+	}
+
+	// shared owners are not tracked for the hold time
+	if( exclusive ) {
+		acquired_at = t;
+	}
+}
+
+void MutexProfile::released()
+{
+	update_max( max_hold_ns, now() - acquired_at );
+}
+
+void MutexProfile::clear()
+{
+	acquisitions.store( 0, std::memory_order_relaxed );
+	contended.store( 0, std::memory_order_relaxed );
+	total_wait_ns.store( 0, std::memory_order_relaxed );
+	max_wait_ns.store( 0, std::memory_order_relaxed );
+	max_hold_ns.store( 0, std::memory_order_relaxed );
+}
+
+MutexProfiler::Entry MutexProfile::getEntry() const
+{
+	MutexProfiler::Entry e;
+
+	if( name ) {
+		e.name = name;
+	} else if( const char *f = file.load( std::memory_order_relaxed ) ) {
+		e.name = format( "%s:%d", f, line.load( std::memory_order_relaxed ) );
+	} else {
+		e.name = "<unnamed>";
+	}
+
+	e.mutexes       = 1;
+	e.acquisitions  = acquisitions.load( std::memory_order_relaxed );
+	e.contended     = contended.load( std::memory_order_relaxed );
+	e.total_wait_ns = total_wait_ns.load( std::memory_order_relaxed );
+	e.max_wait_ns   = max_wait_ns.load( std::memory_order_relaxed );
+	e.max_hold_ns   = max_hold_ns.load( std::memory_order_relaxed );
+
+	return e;
+}
+
+std::vector<MutexProfiler::Entry> MutexProfiler::snapshot()
+{
+	Registry & r = registry();
+	std::map<std::string,Entry> sums;
+
+	{
+		std::lock_guard<std::mutex> lock( r.mutex );
+
+		sums = r.retired;
+
+		for( MutexProfile *p = r.head; p; p = p->next ) {
+			Entry e = p->getEntry();
+
+			if( e.acquisitions == 0 ) {
+				continue;
+			}
+
+			Entry & sum = sums[e.name];
+			sum.name = e.name;
+			add_entry( sum, e );
+		}
+	}
+
+	std::vector<Entry> res;
+	res.reserve( sums.size() );
+
+	for( auto & pair : sums ) {
+		res.push_back( pair.second );
+	}
+
+	std::sort( res.begin(), res.end(), []( const Entry & a, const Entry & b ) {
+		if( a.total_wait_ns != b.total_wait_ns ) {
+			return a.total_wait_ns > b.total_wait_ns;
+		}
+		return a.contended > b.contended;
+	});
+
+	return res;
+}
+
+void MutexProfiler::reset()
+{
+	Registry & r = registry();
+	std::lock_guard<std::mutex> lock( r.mutex );
+
+	r.retired.clear();
+
+	for( MutexProfile *p = r.head; p; p = p->next ) {
+		p->clear();
+	}
+}
+
+#else
+
+std::vector<MutexProfiler::Entry> MutexProfiler::snapshot()
+{
+	return {};
+}
+
+void MutexProfiler::reset()
+{
+}
+
+#endif // TOOLS_MUTEX_PROFILING
+
+void MutexProfiler::report( std::ostream & out, [[maybe_unused]] size_t max_entries )
+{
+#ifndef TOOLS_MUTEX_PROFILING
+	out << "mutex profiling is disabled, compile with -DTOOLS_MUTEX_PROFILING\n";
+#else
+	std::vector<Entry> entries = snapshot();
+
+	if( max_entries > 0 && entries.size() > max_entries ) {
+		entries.resize( max_entries );
+	}
+
+	out << format( "%-50s %8s %12s %12s %12s %12s %12s\n",
+				   "mutex", "count", "acquired", "contended", "wait ms", "max wait us", "max hold us" );
+
+	for( const Entry & e : entries ) {
+		out << format( "%-50s %8d %12d %12d %12.3f %12.1f %12.1f\n",
+					   e.name,
+					   e.mutexes,
+					   e.acquisitions,
+					   e.contended,
+					   e.total_wait_ns / 1e6,
+					   e.max_wait_ns / 1e3,
+					   e.max_hold_ns / 1e3 );
+	}
+#endif
+}
+
+void MutexProfiler::report_to_debug( size_t max_entries )
+{
+	if( !x_debug ) {
+		return;
+	}
+
+	std::stringstream str;
+	report( str, max_entries );
+
+	std::string line;
+
+	while( std::getline( str, line ) ) {
+		x_debug->add( __FILE__, __LINE__, __FUNCTION__, line );
+	}
+}
+
+bool MutexProfiler::report_to_file( const std::string & file_name, size_t max_entries )
+{
+	std::ofstream out( file_name );
+
+	if( !out ) {
+		return false;
+	}
+
+	report( out, max_entries );
+
+	return static_cast<bool>(out);
+}
+
+} // namespace Tools
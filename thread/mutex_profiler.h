@@ -0,0 +1,125 @@
+/**
+ * Lock contention profiler
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Compile everything with -DTOOLS_MUTEX_PROFILING to enable it.
+ * Then Thread::Mutex, AdaptiveMutex, SharedMutex and DistributedSharedMutex
+ * are recording per mutex:
+ *    number of acquisitions, contended acquisitions,
+ *    total and max wait time, max hold time
+ *
+ * A mutex is identified by the name passed to its constructor,
+ * or by the source location of the first Thread::MutexLock that locked it.
+ * Mutexes with the same name or location are summed up in the report.
+ *
+ *    Tools::AdaptiveMutex cache_mutex( "cache" );
+ *    ...
+ *    Tools::MutexProfiler::report_to_debug();
+ *    Tools::MutexProfiler::report_to_file( "/tmp/mutexes.txt" );
+ *
+ * Without TOOLS_MUTEX_PROFILING the mutexes contain no profiling
+ * code at all, and the report is empty.
+ */
+#ifndef TOOLS_MUTEX_PROFILER_H
+#define TOOLS_MUTEX_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#ifdef TOOLS_MUTEX_PROFILING
+#  include <source_location>
+#endif
+
+namespace Tools {
+
+namespace MutexProfiler {
+
+struct Entry
+{
+	std::string name;            // name, or file:line
+	uint64_t    mutexes = 0;     // number of mutex instances
+	uint64_t    acquisitions = 0;
+	uint64_t    contended = 0;
+	uint64_t    total_wait_ns = 0;
+	uint64_t    max_wait_ns = 0;
+	uint64_t    max_hold_ns = 0;
+};
+
+// all entries, the most total waiting time first
+std::vector<Entry> snapshot();
+
+void report( std::ostream & out, size_t max_entries = 0 );
+
+// via Tools::x_debug
+void report_to_debug( size_t max_entries = 0 );
+
+// returns false, if the file cannot be opened
+bool report_to_file( const std::string & file_name, size_t max_entries = 0 );
+
+// clears the statistics of all mutexes
+void reset();
+
+} // namespace MutexProfiler
+
+#ifdef TOOLS_MUTEX_PROFILING
+
+/**
+ * The profiling data, that is embedded in every mutex.
+ * acquired() and released() have to be called by the holder of the mutex.
+ */
+class MutexProfile
+{
+	const char *name;
+	std::atomic<const char*> file;
+	std::atomic<unsigned>    line;
+
+	std::atomic<uint64_t> acquisitions;
+	std::atomic<uint64_t> contended;
+	std::atomic<uint64_t> total_wait_ns;
+	std::atomic<uint64_t> max_wait_ns;
+	std::atomic<uint64_t> max_hold_ns;
+
+	// only accessed by the holder of the mutex
+	uint64_t acquired_at;
+
+	// registry list
+	MutexProfile *prev;
+	MutexProfile *next;
+
+public:
+	explicit MutexProfile( const char *name = nullptr );
+	~MutexProfile();
+
+	MutexProfile( const MutexProfile & other ) = delete;
+	MutexProfile & operator=( const MutexProfile & other ) = delete;
+
+	static uint64_t now();
+
+	// wait_start == 0: the mutex was not contended
+	void acquired( uint64_t wait_start, bool exclusive = true );
+	void released();
+
+	void setLocation( const std::source_location & location ) {
+		const char *expected = nullptr;
+
+		if( !name && !file.load( std::memory_order_relaxed ) &&
+			file.compare_exchange_strong( expected, location.file_name(), std::memory_order_relaxed ) ) {
+			line.store( location.line(), std::memory_order_relaxed );
+		}
+	}
+
+	void clear();
+	MutexProfiler::Entry getEntry() const;
+
+	friend std::vector<MutexProfiler::Entry> MutexProfiler::snapshot();
+	friend void MutexProfiler::reset();
+};
+
+#endif // TOOLS_MUTEX_PROFILING
+
+} // namespace Tools
+
+#endif
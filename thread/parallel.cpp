@@ -0,0 +1,20 @@
+#include "parallel.h"
+
+#ifdef TOOLS_USE_THREADS
+
+namespace Tools {
+
+namespace detail {
+
+ThreadPool & parallel_pool()
+{
+	// the calling thread is working too
+	static ThreadPool pool( std::max( 1, Thread::processors() - 1 ) );
+	return pool;
+}
+
+} // namespace detail
+
+} // namespace Tools
+
+#endif
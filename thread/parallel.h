@@ -0,0 +1,269 @@
+/**
+ * parallel algorithms on contiguous containers
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Works with everything that has data() and size(), like std::vector,
+ * static_vector, span_vector, std::array, or std::span.
+ *
+ * Examples:
+ *    std::vector<double> v( 10000000 );
+ *
+ *    Tools::parallel_for( v, 0, []( double & d ) { d = std::sqrt(d); } );
+ *
+ *    double sum = Tools::parallel_reduce( v, 0.0, std::plus<double>() );
+ *
+ *    Tools::parallel_sort( v );
+ *
+ * The work is split into chunks of grain elements. With grain == 0 the
+ * size is chosen automatically. The chunks are executed on the internal
+ * ThreadPool (one worker per processor) and on the calling thread.
+ */
+#ifndef TOOLS_PARALLEL_H
+#define TOOLS_PARALLEL_H
+
+#include "thread_pool.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <exception>
+
+namespace Tools {
+
+namespace detail {
+
+// the worker set used by the parallel algorithms
+ThreadPool & parallel_pool();
+
+inline size_t auto_grain( size_t count, size_t workers )
+{
+	// some chunks more than workers, so the stealing can balance
+	const size_t chunks = std::max<size_t>( 1, workers * 4 );
+	return std::max<size_t>( 1, (count + chunks - 1) / chunks );
+}
+
+/**
+ * Runs func( first, last ) for every chunk of [0,count)
+ * and waits until all chunks are done.
+ */
+template <class Func>
+void parallel_chunks( size_t count, size_t grain, Func && func )
+{
+	if( count == 0 ) {
+		return;
+	}
+
+	ThreadPool & pool = parallel_pool();
+
+	if( grain == 0 ) {
+		grain = auto_grain( count, pool.size() );
+	}
+
+	if( grain >= count ) {
+		func( size_t(0), count );
+		return;
+	}
+
+	std::vector<ThreadPool::Future<void>> futures;
+	futures.reserve( count / grain );
+
+	// the first chunk is done by the calling thread
+	for( size_t first = grain; first < count; first += grain ) {
+		const size_t last = std::min( count, first + grain );
+		futures.push_back( pool.submit( [&func, first, last]() { func( first, last ); } ) );
+	}
+
+	std::exception_ptr error;
+
+	try {
+		func( size_t(0), grain );
+	} catch( ... ) {
+		error = std::current_exception();
+	}
+
+	// wait for all of them, before the first error is rethrown,
+	// they are referencing func
+	for( auto & future : futures ) {
+		try {
+			future.get();
+		} catch( ... ) {
+			if( !error ) {
+				error = std::current_exception();
+			}
+		}
+	}
+
+	if( error ) {
+		std::rethrow_exception( error );
+	}
+}
+
+template <class Range>
+auto as_span( Range & range )
+{
+	return std::span( std::data( range ), std::size( range ) );
+}
+
+} // namespace detail
+
+/**
+ * calls func( size_t index ) for every index in [first,last)
+ */
+template <class Func>
+void parallel_for( size_t first, size_t last, size_t grain, Func && func )
+{
+	if( last <= first ) {
+		return;
+	}
+
+	detail::parallel_chunks( last - first, grain, [first, &func]( size_t a, size_t b ) {
+		for( size_t i = first + a; i < first + b; ++i ) {
+			func( i );
+		}
+	});
+}
+
+/**
+ * calls func( element ) for every element of the range
+ */
+template <class Range, class Func>
+void parallel_for( Range & range, size_t grain, Func && func )
+{
+	auto data = detail::as_span( range );
+
+	detail::parallel_chunks( data.size(), grain, [&data, &func]( size_t a, size_t b ) {
+		for( size_t i = a; i < b; ++i ) {
+			func( data[i] );
+		}
+	});
+}
+
+/**
+ * Reduces map( index ) for every index in [first,last) with reduce().
+ *
+ * The result is deterministic: every chunk is reduced from left to right,
+ * then the chunk results are combined from left to right, starting with init.
+ * With grain == 0 the chunk size only depends on the number of elements,
+ * not on the number of processors. So even floating point results are
+ * the same on every machine.
+ */
+template <class T, class Map, class Reduce>
+T parallel_reduce( size_t first, size_t last, T init, Map && map, Reduce && reduce, size_t grain = 0 )
+{
+	if( last <= first ) {
+		return init;
+	}
+
+	const size_t count = last - first;
+
+	if( grain == 0 ) {
+		grain = std::max<size_t>( 1024, (count + 255) / 256 );
+	}
+
+	const size_t chunks = (count + grain - 1) / grain;
+	std::vector<std::optional<T>> partial( chunks );
+
+	detail::parallel_chunks( chunks, 0, [&]( size_t c, size_t c_end ) {
+		for( ; c < c_end; ++c ) {
+			const size_t a = first + c * grain;
+			const size_t b = std::min( last, a + grain );
+
+			T value = map( a );
+
+			for( size_t i = a + 1; i < b; ++i ) {
+				value = reduce( std::move(value), map( i ) );
+			}
+
+			partial[c].emplace( std::move(value) );
+		}
+	});
+
+	for( auto & p : partial ) {
+		init = reduce( std::move(init), std::move(*p) );
+	}
+
+	return init;
+}
+
+/**
+ * Reduces all elements of the range, see above
+ */
+template <class Range, class T, class Reduce>
+T parallel_reduce( const Range & range, T init, Reduce && reduce, size_t grain = 0 )
+{
+	auto data = detail::as_span( range );
+
+	return parallel_reduce( 0, data.size(), std::move(init),
+							[&data]( size_t i ) -> const auto & { return data[i]; },
+							reduce, grain );
+}
+
+/**
+ * Sorts the range. Chunks are sorted in parallel, then merged
+ * pairwise in parallel rounds. Needs a temporary buffer of the
+ * range's size. Not stable.
+ */
+template <class Range, class Compare = std::less<>>
+void parallel_sort( Range & range, Compare comp = Compare(), size_t grain = 0 )
+{
+	auto data = detail::as_span( range );
+	typedef typename decltype(data)::value_type T;
+
+	const size_t count = data.size();
+
+	if( grain == 0 ) {
+		grain = std::max<size_t>( 4096, detail::auto_grain( count, detail::parallel_pool().size() ) );
+	}
+
+	if( count <= grain ) {
+		std::sort( data.begin(), data.end(), comp );
+		return;
+	}
+
+	detail::parallel_chunks( (count + grain - 1) / grain, 0, [&]( size_t c, size_t c_end ) {
+		for( ; c < c_end; ++c ) {
+			const size_t a = c * grain;
+			const size_t b = std::min( count, a + grain );
+			std::sort( data.begin() + a, data.begin() + b, comp );
+		}
+	});
+
+	std::vector<T> buffer( std::make_move_iterator( data.begin() ), std::make_move_iterator( data.end() ) );
+	std::span<T> from( buffer );
+	std::span<T> to( data.data(), count );
+	bool result_in_data = false;
+
+	for( size_t width = grain; width < count; width *= 2 ) {
+		const size_t pairs = (count + 2 * width - 1) / (2 * width);
+
+		detail::parallel_chunks( pairs, 1, [&]( size_t p, size_t p_end ) {
+			for( ; p < p_end; ++p ) {
+				const size_t a = p * 2 * width;
+				const size_t m = std::min( count, a + width );
+				const size_t b = std::min( count, a + 2 * width );
+
+				std::merge( std::make_move_iterator( from.begin() + a ), std::make_move_iterator( from.begin() + m ),
+							std::make_move_iterator( from.begin() + m ), std::make_move_iterator( from.begin() + b ),
+							to.begin() + a, comp );
+			}
+		});
+
+		std::swap( from, to );
+		result_in_data = !result_in_data;
+	}
+
+	if( !result_in_data ) {
+		std::move( buffer.begin(), buffer.end(), data.begin() );
+	}
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * Substring search on several threads, for very large haystacks
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::parallel_find_all_of( dump, "ERROR", [&]( size_t pos ) {
+ *       report( pos );
+ *       return true;
+ *    });
+ *
+ * The haystack is split into chunks of grain characters (default:
+ * automatically, at least 1MB), that are searched in parallel on the
+ * ThreadPool of parallel.h. A match can start in one chunk and end in
+ * the next one, so matches across chunk borders are found too.
+ *
+ * The callback is called on the calling thread, in ascending order,
+ * with the same non overlapping matches as find_all_of(). A chunk is
+ * reported as soon as it and all chunks before it are searched.
+ * Returning false stops the search of the remaining chunks.
+ *
+ * Every chunk keeps only the non overlapping matches, starting at its
+ * first position. If the last match of the previous chunk ends inside
+ * the chunk, the overlapped matches are searched again. This is cheap,
+ * except for periodic needles, like "aa" in "aaaa...", there the
+ * offsets can differ up to the end of the chunk.
+ */
+#ifndef TOOLS_PARALLEL_FIND_H
+#define TOOLS_PARALLEL_FIND_H
+
+#include "parallel.h"
+#include <string_searcher.h>
+
+#ifdef TOOLS_USE_THREADS
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+namespace Tools {
+
+template <class CharT, class Func>
+void parallel_find_all( const CharT *haystack, size_t len,
+						const basic_string_searcher<CharT> & searcher,
+						Func && func, size_t grain = 0 )
+{
+	static const size_t MIN_GRAIN = 1024 * 1024;
+	const size_t npos = basic_string_searcher<CharT>::npos;
+	const size_t m = searcher.size();
+	ThreadPool & pool = detail::parallel_pool();
+
+	if( grain == 0 ) {
+		grain = std::max( MIN_GRAIN, detail::auto_grain( len, pool.size() + 1 ) );
+	}
+
+	if( m == 0 || len <= grain ) {
+		searcher.find_all( haystack, len, func );
+		return;
+	}
+
+	const size_t chunks = (len + grain - 1) / grain;
+
+	// the non overlapping matches of each chunk, starting at its first position
+	std::vector<std::vector<size_t>> found( chunks );
+	std::atomic<bool> stop = false;
+
+	auto search = [&]( size_t c ) {
+		const size_t first = c * grain;
+		const size_t last = std::min( len, first + grain );
+		// the last match may end behind last
+		const size_t end = std::min( len, last + m - 1 );
+		std::vector<size_t> & res = found[c];
+
+		for( size_t pos = first;
+			 !stop.load( std::memory_order_relaxed ) &&
+			 (pos = searcher.find( haystack, end, pos )) != npos && pos < last;
+			 pos += m ) {
+			res.push_back( pos );
+		}
+	};
+
+	// next: the end of the last reported match
+	auto merge = [&]( size_t c, size_t & next ) {
+		const size_t last = std::min( len, (c + 1) * grain );
+		const size_t end = std::min( len, last + m - 1 );
+		const std::vector<size_t> & res = found[c];
+		size_t i = 0;
+
+		// The previous match ends inside this chunk. The matches overlapping
+		// it are replaced by the ones starting at next, until one of them
+		// is a match of the chunk again, from there on both are the same.
+		while( i < res.size() && res[i] < next ) {
+			const size_t pos = searcher.find( haystack, end, next );
+
+			if( pos == npos || pos >= last ) {
+				return true;
+			}
+
+			while( i < res.size() && res[i] < pos ) {
+				++i;
+			}
+
+			if( i < res.size() && res[i] == pos ) {
+				break;
+			}
+
+			if( !func( pos ) ) {
+				return false;
+			}
+
+			next = pos + m;
+		}
+
+		for( ; i < res.size(); ++i ) {
+			if( !func( res[i] ) ) {
+				return false;
+			}
+
+			next = res[i] + m;
+		}
+
+		return true;
+	};
+
+	std::vector<ThreadPool::Future<void>> futures;
+	futures.reserve( chunks - 1 );
+
+	// the first chunk is searched by the calling thread, the
+	// others are merged in order, as soon as they are done
+	for( size_t c = 1; c < chunks; ++c ) {
+		futures.push_back( pool.submit( [&search, c]() { search( c ); } ) );
+	}
+
+	std::exception_ptr error;
+
+	try {
+		size_t next = 0;
+
+		search( 0 );
+
+		for( size_t c = 0; c < chunks; ++c ) {
+			if( c > 0 ) {
+				futures[c - 1].get();
+			}
+
+			if( !merge( c, next ) ) {
+				break;
+			}
+		}
+	} catch( ... ) {
+		error = std::current_exception();
+	}
+
+	// the remaining chunks are only finishing their current find()
+	stop.store( true, std::memory_order_relaxed );
+
+	// they are referencing the local variables
+	for( auto & future : futures ) {
+		if( future.valid() ) {
+			future.wait();
+		}
+	}
+
+	if( error ) {
+		std::rethrow_exception( error );
+	}
+}
+
+template <class Func>
+void parallel_find_all_of( const std::string & haystack, const std::string & needle, Func && func, size_t grain = 0 )
+{
+	string_searcher searcher( needle );
+	parallel_find_all( haystack.data(), haystack.size(), searcher, func, grain );
+}
+
+template <class Func>
+void parallel_find_all_of( const std::wstring & haystack, const std::wstring & needle, Func && func, size_t grain = 0 )
+{
+	wstring_searcher searcher( needle );
+	parallel_find_all( haystack.data(), haystack.size(), searcher, func, grain );
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
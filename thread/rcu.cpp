@@ -0,0 +1,205 @@
+#include "rcu.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#  include <linux/membarrier.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace Tools {
+
+namespace detail {
+
+// starts at 1, 0 is used for readers outside a read section
+std::atomic<uint64_t> rcu_global_epoch = 1;
+bool rcu_use_membarrier = false;
+thread_local RcuReader *rcu_reader = nullptr;
+
+} // namespace detail
+
+namespace {
+
+struct Retired
+{
+	void *object;
+	void (*deleter)( void* );
+	uint64_t epoch;
+};
+
+struct Domain
+{
+	// the readers are never freed, they are reused by new threads
+	std::mutex readers_mutex;
+	std::atomic<detail::RcuReader*> readers = nullptr;
+
+	std::mutex retired_mutex;
+	std::vector<Retired> retired;
+
+	Domain() {
+#ifdef __linux__
+		if( syscall( SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0 ) == 0 ) {
+			detail::rcu_use_membarrier = true;
+		}
+#endif
+	}
+};
+
+Domain & domain()
+{
+	// leaked, readers may be active during static destruction
+	static Domain *d = new Domain();
+	return *d;
+}
+
+// gives the reader free again, when the thread exits
+struct ReaderRelease
+{
+	detail::RcuReader *reader = nullptr;
+
+	~ReaderRelease() {
+		if( reader ) {
+			reader->epoch.store( 0, std::memory_order_release );
+			reader->nesting = 0;
+			reader->in_use.store( false, std::memory_order_release );
+			detail::rcu_reader = nullptr;
+		}
+	}
+};
+
+thread_local ReaderRelease reader_release;
+
+// makes the readers' epochs visible to the calling writer
+void writer_fence()
+{
+#ifdef __linux__
+	if( detail::rcu_use_membarrier ) {
+		syscall( SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0 );
+		return;
+	}
+#endif
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+}
+
+/**
+ * Returns the oldest epoch, that is still announced by a reader,
+ * or current, if there is no older one.
+ */
+uint64_t oldest_active_epoch( Domain & d, uint64_t current )
+{
+	writer_fence();
+
+	uint64_t res = current;
+
+	for( detail::RcuReader *r = d.readers.load( std::memory_order_acquire ); r; r = r->next ) {
+		const uint64_t epoch = r->epoch.load( std::memory_order_acquire );
+
+		if( epoch != 0 ) {
+			res = std::min( res, epoch );
+		}
+	}
+
+	return res;
+}
+
+// frees everything, that no reader can see any more
+void collect( Domain & d, uint64_t current )
+{
+	const uint64_t oldest = oldest_active_epoch( d, current );
+	std::vector<Retired> expired;
+
+	{
+		std::lock_guard<std::mutex> lock( d.retired_mutex );
+
+		auto it = std::partition( d.retired.begin(), d.retired.end(),
+								  [oldest]( const Retired & r ) { return r.epoch >= oldest; } );
+
+		expired.assign( it, d.retired.end() );
+		d.retired.erase( it, d.retired.end() );
+	}
+
+	// outside the lock, a destructor may retire objects too
+	for( const Retired & r : expired ) {
+		r.deleter( r.object );
+	}
+}
+
+} // namespace
+
+detail::RcuReader *detail::rcu_register_reader()
+{
+	Domain & d = domain();
+	RcuReader *reader = nullptr;
+
+	for( RcuReader *r = d.readers.load( std::memory_order_acquire ); r; r = r->next ) {
+		bool expected = false;
+
+		if( !r->in_use.load( std::memory_order_relaxed ) &&
+			r->in_use.compare_exchange_strong( expected, true, std::memory_order_acquire ) ) {
+			reader = r;
+			break;
+		}
+	}
+
+	if( !reader ) {
+		std::lock_guard<std::mutex> lock( d.readers_mutex );
+
+		reader = new RcuReader();
+		reader->in_use.store( true, std::memory_order_relaxed );
+		reader->next = d.readers.load( std::memory_order_relaxed );
+		d.readers.store( reader, std::memory_order_release );
+	}
+
+	reader_release.reader = reader;
+	rcu_reader = reader;
+
+	return reader;
+}
+
+void detail::rcu_retire( void *object, void (*deleter)( void* ) )
+{
+	Domain & d = domain();
+
+	// readers, that are entering from now on, cannot see the object
+	const uint64_t epoch = rcu_global_epoch.fetch_add( 1, std::memory_order_acq_rel );
+
+	{
+		std::lock_guard<std::mutex> lock( d.retired_mutex );
+		d.retired.push_back( Retired{ object, deleter, epoch } );
+	}
+
+	collect( d, epoch + 1 );
+}
+
+void Rcu::synchronize()
+{
+	if( detail::rcu_reader && detail::rcu_reader->nesting > 0 ) {
+		throw REPORT_EXCEPTION( "Rcu::synchronize() called inside a read section" );
+	}
+
+	Domain & d = domain();
+	const uint64_t epoch = detail::rcu_global_epoch.fetch_add( 1, std::memory_order_acq_rel );
+
+	while( oldest_active_epoch( d, epoch + 1 ) <= epoch ) {
+		std::this_thread::yield();
+	}
+
+	collect( d, epoch + 1 );
+}
+
+size_t Rcu::pending()
+{
+	Domain & d = domain();
+	std::lock_guard<std::mutex> lock( d.retired_mutex );
+
+	return d.retired.size();
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
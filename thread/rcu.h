@@ -0,0 +1,248 @@
+/**
+ * Read-copy-update pointer with epoch based reclamation
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::RcuPtr<RoutingTable> routes( std::make_unique<RoutingTable>() );
+ *
+ *    // readers, on every request
+ *    {
+ *       auto table = routes.read();
+ *       forward( table->lookup( address ) );
+ *    }
+ *
+ *    // writers, rarely
+ *    routes.update( load_routing_table() );
+ *    routes.modify( []( RoutingTable & table ) { table.add( entry ); } );
+ *
+ * Readers only store their epoch into their own cache line, when they
+ * are entering and leaving a read section. There is no atomic
+ * read-modify-write and no lock, so readers never wait for writers
+ * and are not slowing down each other.
+ *
+ * The replaced versions are freed, after all readers, that could
+ * have seen them, have left their read section. Writers never block
+ * for this, the versions are collected by later updates, or by
+ * Rcu::synchronize().
+ *
+ * On Linux the readers do not need a memory fence, if the kernel supports
+ * membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) (4.14+). The writers are
+ * doing the expensive part then.
+ *
+ * Read sections can be nested. Rcu::synchronize() checks, if the calling
+ * thread is inside a read section, and throws the exception of
+ * REPORT_EXCEPTION() then, instead of waiting for itself forever.
+ */
+#ifndef TOOLS_RCU_H
+#define TOOLS_RCU_H
+
+#include "thread.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace Tools {
+
+namespace detail {
+
+struct alignas(64) RcuReader
+{
+	// 0: not inside a read section
+	std::atomic<uint64_t> epoch = 0;
+	unsigned nesting = 0;
+	std::atomic<bool> in_use = false;
+	RcuReader *next = nullptr;
+};
+
+extern std::atomic<uint64_t> rcu_global_epoch;
+extern bool rcu_use_membarrier;
+extern thread_local RcuReader *rcu_reader;
+
+RcuReader *rcu_register_reader();
+
+void rcu_retire( void *object, void (*deleter)( void* ) );
+
+} // namespace detail
+
+namespace Rcu {
+
+inline void read_lock()
+{
+	detail::RcuReader *reader = detail::rcu_reader;
+
+	if( !reader ) {
+		reader = detail::rcu_register_reader();
+	}
+
+	if( reader->nesting++ == 0 ) {
+		reader->epoch.store( detail::rcu_global_epoch.load( std::memory_order_acquire ), std::memory_order_relaxed );
+
+		// the epoch has to be visible, before the pointer is read.
+		// With membarrier() the writers are forcing this.
+		if( detail::rcu_use_membarrier ) {
+			std::atomic_signal_fence( std::memory_order_seq_cst );
+		} else {
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+		}
+	}
+}
+
+inline void read_unlock()
+{
+	detail::RcuReader *reader = detail::rcu_reader;
+
+	if( --reader->nesting == 0 ) {
+		reader->epoch.store( 0, std::memory_order_release );
+	}
+}
+
+/**
+ * Read section, that can cover several RcuPtr reads
+ */
+class ReadLock
+{
+public:
+	ReadLock() {
+		read_lock();
+	}
+
+	~ReadLock() {
+		read_unlock();
+	}
+
+	ReadLock( const ReadLock & other ) = delete;
+	ReadLock & operator=( const ReadLock & other ) = delete;
+};
+
+/**
+ * Waits until all read sections, that were active when it was called,
+ * have been left, and frees the retired objects.
+ * Throws REPORT_EXCEPTION( "Rcu::synchronize() called inside a read section" ),
+ * if the calling thread holds a ReadLock.
+ */
+void synchronize();
+
+/**
+ * The object is deleted, after all current readers are gone.
+ * It must not be reachable for new readers any more.
+ */
+template <class T>
+void retire( T *object )
+{
+	if( object ) {
+		detail::rcu_retire( object, []( void *p ) { delete static_cast<T*>( p ); } );
+	}
+}
+
+// number of retired objects, that are not freed yet
+size_t pending();
+
+} // namespace Rcu
+
+template <class T>
+class RcuPtr
+{
+	std::atomic<T*> ptr;
+
+	// serializes modify()
+	std::mutex writer_mutex;
+
+public:
+	/**
+	 * A snapshot of the current version.
+	 * It stays valid, as long as the guard lives.
+	 */
+	class ReadGuard
+	{
+		const T *value;
+
+	public:
+		explicit ReadGuard( const std::atomic<T*> & ptr ) {
+			Rcu::read_lock();
+			value = ptr.load( std::memory_order_acquire );
+		}
+
+		~ReadGuard() {
+			Rcu::read_unlock();
+		}
+
+		ReadGuard( const ReadGuard & other ) = delete;
+		ReadGuard & operator=( const ReadGuard & other ) = delete;
+
+		const T * get() const {
+			return value;
+		}
+
+		const T * operator->() const {
+			return value;
+		}
+
+		const T & operator*() const {
+			return *value;
+		}
+
+		explicit operator bool() const {
+			return value != nullptr;
+		}
+	};
+
+	RcuPtr()
+	: ptr( nullptr )
+	{}
+
+	explicit RcuPtr( std::unique_ptr<T> value )
+	: ptr( value.release() )
+	{}
+
+	// the current version is retired, readers may still use it
+	~RcuPtr() {
+		Rcu::retire( ptr.load( std::memory_order_relaxed ) );
+	}
+
+	RcuPtr( const RcuPtr & other ) = delete;
+	RcuPtr & operator=( const RcuPtr & other ) = delete;
+
+	ReadGuard read() const {
+		return ReadGuard( ptr );
+	}
+
+	/**
+	 * The raw pointer, only valid inside a
+	 * read section (Rcu::ReadLock)
+	 */
+	const T * load() const {
+		return ptr.load( std::memory_order_acquire );
+	}
+
+	// publishes the new version, the old one is retired
+	void update( std::unique_ptr<T> value ) {
+		Rcu::retire( ptr.exchange( value.release(), std::memory_order_acq_rel ) );
+	}
+
+	/**
+	 * Copies the current version, calls func( T & ) on the copy,
+	 * and publishes it. Concurrent modify() calls are serialized,
+	 * so no modification gets lost.
+	 */
+	template <class Func>
+	void modify( Func func ) {
+		std::lock_guard<std::mutex> lock( writer_mutex );
+
+		const T *current = ptr.load( std::memory_order_acquire );
+		std::unique_ptr<T> copy = current ? std::make_unique<T>( *current ) : std::make_unique<T>();
+
+		func( *copy );
+		update( std::move(copy) );
+	}
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
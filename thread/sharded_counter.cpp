@@ -0,0 +1,176 @@
+#include "sharded_counter.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <format.h>
+#include <algorithm>
+#include <sched.h>
+
+namespace Tools {
+
+namespace {
+
+std::atomic<unsigned> next_thread_index = 0;
+thread_local unsigned thread_index = next_thread_index.fetch_add( 1, std::memory_order_relaxed );
+
+} // namespace
+
+unsigned detail::shard_index()
+{
+#ifdef __linux__
+	int cpu = sched_getcpu();
+
+	if( cpu >= 0 ) {
+		return static_cast<unsigned>( cpu );
+	}
+#endif
+
+	return thread_index;
+}
+
+unsigned detail::shard_count( unsigned slots )
+{
+	if( slots == 0 ) {
+		slots = static_cast<unsigned>( std::max( 1, Thread::processors() ) );
+	}
+
+	unsigned res = 1;
+
+	while( res < slots ) {
+		res <<= 1;
+	}
+
+	return res;
+}
+
+ShardedCounter::ShardedCounter( const std::string & name_, unsigned slots_ )
+: name( name_ ),
+  mask( detail::shard_count( slots_ ) - 1 ),
+  slots( new Slot[mask + 1] )
+{
+}
+
+int64_t ShardedCounter::value() const
+{
+	int64_t res = 0;
+
+	for( unsigned i = 0; i <= mask; ++i ) {
+		res += slots[i].value.load( std::memory_order_relaxed );
+	}
+
+	return res;
+}
+
+void ShardedCounter::reset()
+{
+	for( unsigned i = 0; i <= mask; ++i ) {
+		slots[i].value.store( 0, std::memory_order_relaxed );
+	}
+}
+
+ShardedCounter::Snapshot ShardedCounter::snapshot() const
+{
+	Snapshot res;
+	res.name = name;
+	res.shards.reserve( mask + 1 );
+
+	for( unsigned i = 0; i <= mask; ++i ) {
+		res.shards.push_back( slots[i].value.load( std::memory_order_relaxed ) );
+		res.value += res.shards.back();
+	}
+
+	return res;
+}
+
+std::string ShardedCounter::Snapshot::toString() const
+{
+	return format( "%s: %d", name, value );
+}
+
+ShardedHistogram::ShardedHistogram( const std::string & name_, unsigned slots_ )
+: name( name_ ),
+  mask( detail::shard_count( slots_ ) - 1 ),
+  slots( new Slot[mask + 1] )
+{
+}
+
+uint64_t ShardedHistogram::count() const
+{
+	uint64_t res = 0;
+
+	for( unsigned i = 0; i <= mask; ++i ) {
+		res += slots[i].count.load( std::memory_order_relaxed );
+	}
+
+	return res;
+}
+
+void ShardedHistogram::reset()
+{
+	for( unsigned i = 0; i <= mask; ++i ) {
+		Slot & slot = slots[i];
+
+		slot.count.store( 0, std::memory_order_relaxed );
+		slot.sum.store( 0, std::memory_order_relaxed );
+		slot.max.store( 0, std::memory_order_relaxed );
+
+		for( auto & b : slot.buckets ) {
+			b.store( 0, std::memory_order_relaxed );
+		}
+	}
+}
+
+ShardedHistogram::Snapshot ShardedHistogram::snapshot() const
+{
+	Snapshot res;
+	res.name = name;
+	res.buckets.resize( BUCKETS );
+
+	for( unsigned i = 0; i <= mask; ++i ) {
+		const Slot & slot = slots[i];
+
+		res.sum += slot.sum.load( std::memory_order_relaxed );
+		res.max = std::max( res.max, slot.max.load( std::memory_order_relaxed ) );
+
+		for( unsigned b = 0; b < BUCKETS; ++b ) {
+			res.buckets[b] += slot.buckets[b].load( std::memory_order_relaxed );
+		}
+	}
+
+	// counted from the buckets, so the percentiles are consistent
+	for( uint64_t b : res.buckets ) {
+		res.count += b;
+	}
+
+	return res;
+}
+
+uint64_t ShardedHistogram::Snapshot::percentile( double p ) const
+{
+	if( count == 0 ) {
+		return 0;
+	}
+
+	const double rank = std::clamp( p, 0.0, 100.0 ) / 100.0 * count;
+	uint64_t seen = 0;
+
+	for( unsigned b = 0; b < buckets.size(); ++b ) {
+		seen += buckets[b];
+
+		if( seen > 0 && seen >= rank ) {
+			return std::min( bucket_limit( b ), max );
+		}
+	}
+
+	return max;
+}
+
+std::string ShardedHistogram::Snapshot::toString() const
+{
+	return format( "%s: count: %d mean: %.1f p50: <=%d p99: <=%d p99.9: <=%d max: %d",
+				   name, count, mean(), percentile( 50 ), percentile( 99 ), percentile( 99.9 ), max );
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
@@ -0,0 +1,202 @@
+/**
+ * Counters and histograms, that are split into one slot per cpu
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    static Tools::ShardedCounter requests( "requests" );
+ *    static Tools::ShardedHistogram latency( "latency[us]" );
+ *
+ *    requests.inc();
+ *    latency.record( elapsed_us );
+ *    ...
+ *    CPPDEBUG( requests.snapshot().toString() );
+ *    CPPDEBUG( latency.snapshot().toString() );
+ *
+ * A plain std::atomic counter, that is incremented by many threads
+ * moves its cache line from core to core on every increment.
+ * Here every cpu increments its own cache line. The slot is chosen
+ * by sched_getcpu() (glibc 2.35+ reads it from rseq, without a syscall).
+ * If that fails, a thread local index is used.
+ *
+ * Reading sums up all slots, so reads are more expensive than writes.
+ * A read, that is concurrent to writes, returns a value in between.
+ */
+#ifndef TOOLS_SHARDED_COUNTER_H
+#define TOOLS_SHARDED_COUNTER_H
+
+#include "thread.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tools {
+
+namespace detail {
+
+// the cpu of the calling thread, or a thread local index
+unsigned shard_index();
+
+// number of slots for the given request, rounded up to a power of 2
+// 0: one slot per processor
+unsigned shard_count( unsigned slots );
+
+} // namespace detail
+
+class ShardedCounter
+{
+	struct alignas(64) Slot
+	{
+		std::atomic<int64_t> value = 0;
+	};
+
+	const std::string        name;
+	const unsigned           mask;
+	std::unique_ptr<Slot[]>  slots;
+
+public:
+	struct Snapshot
+	{
+		std::string          name;
+		int64_t              value = 0;
+		std::vector<int64_t> shards;
+
+		std::string toString() const;
+	};
+
+	/**
+	 * slots: 0 one slot per processor,
+	 *        otherwise it is rounded up to a power of 2
+	 */
+	explicit ShardedCounter( const std::string & name = std::string(), unsigned slots = 0 );
+
+	ShardedCounter( const ShardedCounter & other ) = delete;
+	ShardedCounter & operator=( const ShardedCounter & other ) = delete;
+
+	void add( int64_t n ) {
+		// another thread can run on the same cpu, so it has to be atomic,
+		// but the cache line is not shared with other cores
+		slots[detail::shard_index() & mask].value.fetch_add( n, std::memory_order_relaxed );
+	}
+
+	void inc() {
+		add( 1 );
+	}
+
+	void dec() {
+		add( -1 );
+	}
+
+	// the sum over all slots
+	int64_t value() const;
+
+	// not atomic, increments during reset() may get lost
+	void reset();
+
+	Snapshot snapshot() const;
+
+	const std::string & getName() const {
+		return name;
+	}
+
+	unsigned getSlotCount() const {
+		return mask + 1;
+	}
+};
+
+/**
+ * Histogram with power of 2 buckets. Bucket 0 counts the zeros,
+ * bucket n the values in [2^(n-1), 2^n - 1].
+ */
+class ShardedHistogram
+{
+public:
+	static constexpr unsigned BUCKETS = 65;
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> count = 0;
+		std::atomic<uint64_t> sum = 0;
+		std::atomic<uint64_t> max = 0;
+		std::atomic<uint64_t> buckets[BUCKETS] = {};
+	};
+
+	const std::string        name;
+	const unsigned           mask;
+	std::unique_ptr<Slot[]>  slots;
+
+public:
+	struct Snapshot
+	{
+		std::string           name;
+		uint64_t              count = 0;
+		uint64_t              sum = 0;
+		uint64_t              max = 0;
+		std::vector<uint64_t> buckets;
+
+		double mean() const {
+			return count ? static_cast<double>(sum) / count : 0.0;
+		}
+
+		/**
+		 * returns the upper bound of the bucket, that contains
+		 * the percentile. p in [0,100]
+		 */
+		uint64_t percentile( double p ) const;
+
+		std::string toString() const;
+	};
+
+	explicit ShardedHistogram( const std::string & name = std::string(), unsigned slots = 0 );
+
+	ShardedHistogram( const ShardedHistogram & other ) = delete;
+	ShardedHistogram & operator=( const ShardedHistogram & other ) = delete;
+
+	void record( uint64_t value ) {
+		Slot & slot = slots[detail::shard_index() & mask];
+
+		slot.count.fetch_add( 1, std::memory_order_relaxed );
+		slot.sum.fetch_add( value, std::memory_order_relaxed );
+		slot.buckets[bucket( value )].fetch_add( 1, std::memory_order_relaxed );
+
+		uint64_t m = slot.max.load( std::memory_order_relaxed );
+
+		while( value > m && !slot.max.compare_exchange_weak( m, value, std::memory_order_relaxed ) ) {
+		}
+	}
+
+	static unsigned bucket( uint64_t value ) {
+		return value == 0 ? 0 : 64 - __builtin_clzll( value );
+	}
+
+	// the largest value of a bucket
+	static uint64_t bucket_limit( unsigned bucket ) {
+		return bucket >= 64 ? UINT64_MAX : (uint64_t(1) << bucket) - 1;
+	}
+
+	uint64_t count() const;
+
+	// not atomic, records during reset() may get lost
+	void reset();
+
+	Snapshot snapshot() const;
+
+	const std::string & getName() const {
+		return name;
+	}
+
+	unsigned getSlotCount() const {
+		return mask + 1;
+	}
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
@@ -0,0 +1,245 @@
+/**
+ * Latch, barrier, semaphore and event on std::atomic::wait
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::Latch ready( workers );
+ *    ...                                  // in each worker
+ *    ready.count_down();
+ *    ...
+ *    ready.wait();
+ *
+ *    Tools::Barrier sync( threads, []() { swap_buffers(); } );
+ *    while( running ) {                   // in each thread
+ *       compute_step();
+ *       sync.arrive_and_wait();           // the last one calls swap_buffers()
+ *    }
+ *
+ *    Tools::CountingSemaphore slots( 16 );
+ *    slots.acquire();
+ *    ...
+ *    slots.release();
+ *
+ *    Tools::ManualResetEvent started;
+ *    started.wait();                      // until someone calls started.set()
+ *
+ * All primitives are a few atomic words. A waiting thread spins a short
+ * time and is parked on a futex afterwards. There is no mutex and no
+ * condition variable involved, and the waking side only enters
+ * the kernel if somebody is sleeping.
+ */
+#ifndef TOOLS_SYNC_H
+#define TOOLS_SYNC_H
+
+#include "mutex.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace Tools {
+
+namespace detail {
+
+// waits until value != old
+inline void wait_while_equal( const std::atomic<uint32_t> & value, uint32_t old )
+{
+	while( value.load( std::memory_order_acquire ) == old ) {
+		if( !spin_while_equal( value, old ) ) {
+			value.wait( old, std::memory_order_acquire );
+		}
+	}
+}
+
+struct NoCompletion
+{
+	void operator()() const noexcept {}
+};
+
+} // namespace detail
+
+/**
+ * Single use counter, threads can wait until it is 0
+ */
+class Latch
+{
+	std::atomic<uint32_t> count;
+
+public:
+	explicit Latch( uint32_t expected )
+	: count( expected )
+	{}
+
+	Latch( const Latch & other ) = delete;
+	Latch & operator=( const Latch & other ) = delete;
+
+	void count_down( uint32_t n = 1 ) {
+		if( count.fetch_sub( n, std::memory_order_acq_rel ) == n ) {
+			count.notify_all();
+		}
+	}
+
+	bool try_wait() const {
+		return count.load( std::memory_order_acquire ) == 0;
+	}
+
+	void wait() const {
+		uint32_t c = count.load( std::memory_order_acquire );
+
+		while( c != 0 ) {
+			detail::wait_while_equal( count, c );
+			c = count.load( std::memory_order_acquire );
+		}
+	}
+
+	void arrive_and_wait( uint32_t n = 1 ) {
+		count_down( n );
+		wait();
+	}
+};
+
+/**
+ * Reusable barrier for a fixed number of threads. When the last
+ * thread arrives, the completion function is called on that thread,
+ * before any thread of this phase is released.
+ * The completion function must not throw.
+ */
+template <class CompletionFunction = detail::NoCompletion>
+class Barrier
+{
+	std::atomic<uint32_t> phase = 0;
+	std::atomic<uint32_t> remaining;
+	std::atomic<uint32_t> expected;
+	CompletionFunction    completion;
+
+public:
+	typedef uint32_t arrival_token;
+
+	explicit Barrier( uint32_t expected_, CompletionFunction completion_ = CompletionFunction() )
+	: remaining( expected_ ),
+	  expected( expected_ ),
+	  completion( std::move(completion_) )
+	{}
+
+	Barrier( const Barrier & other ) = delete;
+	Barrier & operator=( const Barrier & other ) = delete;
+
+	[[nodiscard]] arrival_token arrive( uint32_t n = 1 ) {
+		// the phase cannot move on, before we have arrived
+		const uint32_t current = phase.load( std::memory_order_acquire );
+
+		if( remaining.fetch_sub( n, std::memory_order_acq_rel ) == n ) {
+			completion();
+			remaining.store( expected.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+			phase.store( current + 1, std::memory_order_release );
+			phase.notify_all();
+		}
+
+		return current;
+	}
+
+	void wait( arrival_token token ) const {
+		detail::wait_while_equal( phase, token );
+	}
+
+	void arrive_and_wait() {
+		wait( arrive() );
+	}
+
+	// arrives, and the barrier expects one thread less for the next phases
+	void arrive_and_drop() {
+		expected.fetch_sub( 1, std::memory_order_relaxed );
+		(void)arrive();
+	}
+};
+
+/**
+ * Semaphore, acquire() blocks while the count is 0
+ */
+class CountingSemaphore
+{
+	std::atomic<uint32_t> count;
+
+public:
+	explicit CountingSemaphore( uint32_t initial = 0 )
+	: count( initial )
+	{}
+
+	CountingSemaphore( const CountingSemaphore & other ) = delete;
+	CountingSemaphore & operator=( const CountingSemaphore & other ) = delete;
+
+	void release( uint32_t n = 1 ) {
+		count.fetch_add( n, std::memory_order_release );
+
+		if( n == 1 ) {
+			count.notify_one();
+		} else {
+			count.notify_all();
+		}
+	}
+
+	bool try_acquire() {
+		uint32_t c = count.load( std::memory_order_relaxed );
+
+		while( c > 0 ) {
+			if( count.compare_exchange_weak( c, c - 1, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void acquire() {
+		while( !try_acquire() ) {
+			detail::wait_while_equal( count, 0 );
+		}
+	}
+
+	uint32_t available() const {
+		return count.load( std::memory_order_relaxed );
+	}
+};
+
+/**
+ * Event, that stays set until reset() is called.
+ * All waiting threads are released by set().
+ */
+class ManualResetEvent
+{
+	std::atomic<uint32_t> state;
+
+public:
+	explicit ManualResetEvent( bool initially_set = false )
+	: state( initially_set ? 1 : 0 )
+	{}
+
+	ManualResetEvent( const ManualResetEvent & other ) = delete;
+	ManualResetEvent & operator=( const ManualResetEvent & other ) = delete;
+
+	void set() {
+		if( state.exchange( 1, std::memory_order_release ) == 0 ) {
+			state.notify_all();
+		}
+	}
+
+	void reset() {
+		state.store( 0, std::memory_order_relaxed );
+	}
+
+	bool is_set() const {
+		return state.load( std::memory_order_acquire ) != 0;
+	}
+
+	void wait() const {
+		detail::wait_while_equal( state, 0 );
+	}
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * C++20 coroutine task
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::task<int> answer() {
+ *       co_return 42;
+ *    }
+ *
+ *    Tools::task<void> print() {
+ *       int a = co_await answer();
+ *       std::cout << a << std::endl;
+ *    }
+ *
+ * A task is lazy, it is started when it is awaited, or when it is
+ * spawned onto an EventLoop. Awaiting a task runs it on the awaiting
+ * thread until it suspends. If it is already finished then, the awaiting
+ * coroutine just continues, so long loops of synchronously completing
+ * tasks do not grow the stack, independent of the optimization level.
+ * Otherwise the awaiting coroutine is resumed, when the task finishes.
+ */
+#ifndef TOOLS_TASK_H
+#define TOOLS_TASK_H
+
+#include <coroutine>
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+namespace Tools {
+
+template <class T = void>
+class task;
+
+namespace detail {
+
+class task_promise_base
+{
+	struct final_awaiter
+	{
+		bool await_ready() noexcept {
+			return false;
+		}
+
+		template <class Promise>
+		std::coroutine_handle<> await_suspend( std::coroutine_handle<Promise> h ) noexcept {
+			// the awaiter is still inside of start(), it continues by itself
+			if( !h.promise().handoff.exchange( true, std::memory_order_acq_rel ) ) {
+				return std::noop_coroutine();
+			}
+
+			return h.promise().continuation;
+		}
+
+		void await_resume() noexcept {}
+	};
+
+public:
+	std::coroutine_handle<> continuation = std::noop_coroutine();
+	std::exception_ptr error;
+
+	// set by the first of: the task finished, start() returned.
+	// The second one continues the awaiting coroutine.
+	std::atomic<bool> handoff = false;
+
+	/**
+	 * Runs the task until it suspends the first time.
+	 * returns false, if it finished meanwhile, and awaiting
+	 * has to continue, true if awaiting has to suspend.
+	 */
+	template <class Promise>
+	static bool start( std::coroutine_handle<Promise> h, std::coroutine_handle<> awaiting ) noexcept {
+		h.promise().continuation = awaiting;
+		h.resume();
+
+		return !h.promise().handoff.exchange( true, std::memory_order_acq_rel );
+	}
+
+	std::suspend_always initial_suspend() noexcept {
+		return {};
+	}
+
+	final_awaiter final_suspend() noexcept {
+		return {};
+	}
+
+	void unhandled_exception() {
+		error = std::current_exception();
+	}
+};
+
+template <class T>
+class task_promise : public task_promise_base
+{
+	std::optional<T> value;
+
+public:
+	task<T> get_return_object();
+
+	template <class U>
+	void return_value( U && v ) {
+		value.emplace( std::forward<U>(v) );
+	}
+
+	T result() {
+		if( error ) {
+			std::rethrow_exception( error );
+		}
+
+		return std::move( *value );
+	}
+};
+
+template <>
+class task_promise<void> : public task_promise_base
+{
+public:
+	task<void> get_return_object();
+
+	void return_void() {}
+
+	void result() {
+		if( error ) {
+			std::rethrow_exception( error );
+		}
+	}
+};
+
+} // namespace detail
+
+template <class T>
+class task
+{
+public:
+	typedef detail::task_promise<T> promise_type;
+	typedef std::coroutine_handle<promise_type> handle_type;
+
+private:
+	handle_type handle;
+
+	// awaiting a task, without fetching its result
+	struct ready_awaiter
+	{
+		handle_type handle;
+
+		bool await_ready() const noexcept {
+			return !handle || handle.done();
+		}
+
+		bool await_suspend( std::coroutine_handle<> awaiting ) noexcept {
+			return promise_type::start( handle, awaiting );
+		}
+
+		void await_resume() noexcept {}
+	};
+
+public:
+	task() = default;
+
+	explicit task( handle_type handle_ )
+	: handle( handle_ )
+	{}
+
+	task( task && other ) noexcept
+	: handle( std::exchange( other.handle, nullptr ) )
+	{}
+
+	task & operator=( task && other ) noexcept {
+		if( this != &other ) {
+			if( handle ) {
+				handle.destroy();
+			}
+			handle = std::exchange( other.handle, nullptr );
+		}
+		return *this;
+	}
+
+	task( const task & other ) = delete;
+	task & operator=( const task & other ) = delete;
+
+	~task() {
+		if( handle ) {
+			handle.destroy();
+		}
+	}
+
+	bool valid() const {
+		return handle != nullptr;
+	}
+
+	bool done() const {
+		return handle && handle.done();
+	}
+
+	bool await_ready() const noexcept {
+		return !handle || handle.done();
+	}
+
+	bool await_suspend( std::coroutine_handle<> awaiting ) noexcept {
+		return promise_type::start( handle, awaiting );
+	}
+
+	T await_resume() {
+		return handle.promise().result();
+	}
+
+	/**
+	 * co_await t.when_ready() waits until the task is done,
+	 * but does not fetch the result and does not rethrow exceptions.
+	 */
+	ready_awaiter when_ready() const noexcept {
+		return ready_awaiter{ handle };
+	}
+
+	/**
+	 * returns the result of a finished task,
+	 * or rethrows its exception. Can only be called once.
+	 */
+	T result() {
+		return handle.promise().result();
+	}
+};
+
+template <class T>
+inline task<T> detail::task_promise<T>::get_return_object()
+{
+	return task<T>( std::coroutine_handle<task_promise<T>>::from_promise( *this ) );
+}
+
+inline task<void> detail::task_promise<void>::get_return_object()
+{
+	return task<void>( std::coroutine_handle<task_promise<void>>::from_promise( *this ) );
+}
+
+} // namespace Tools
+
+#endif
@@ -18,6 +18,13 @@
 
 
 #include <iostream>
+#include <algorithm>
+#include "topology.h"
+
+#if defined(__linux__)
+#  include <sched.h>
+#  include <sys/syscall.h>
+#endif
 
 namespace Tools {
                                                                        
@@ -43,6 +50,14 @@ unsigned Thread::Mutex::MutexStruct::id = 1;
 #endif
 
 Thread::Mutex::Mutex()
+: Mutex( nullptr )
+{
+}
+
+Thread::Mutex::Mutex( [[maybe_unused]] const char *name )
+#ifdef TOOLS_MUTEX_PROFILING
+: profile( name )
+#endif
 {
 #ifdef WIN32
     char buffer[50];
@@ -68,15 +83,47 @@ Thread::Mutex::~Mutex()
 
 void Thread::Mutex::lock()
 {
+#ifdef TOOLS_MUTEX_PROFILING
+    if( try_lock() ) {
+        return;
+    }
+
+    uint64_t wait_start = MutexProfile::now();
+#endif
+
 #ifdef WIN32
     WaitForSingleObject( mutex.handle, INFINITE);    
 #else
     pthread_mutex_lock( &mutex );
 #endif
+
+#ifdef TOOLS_MUTEX_PROFILING
+    profile.acquired( wait_start );
+#endif
+}
+
+bool Thread::Mutex::try_lock()
+{
+#ifdef WIN32
+    if( WaitForSingleObject( mutex.handle, 0 ) != WAIT_OBJECT_0 )
+    return false;
+#else
+    if( pthread_mutex_trylock( &mutex ) != 0 )
+    return false;
+#endif
+
+#ifdef TOOLS_MUTEX_PROFILING
+    profile.acquired( 0 );
+#endif
+    return true;
 }
 
 void Thread::Mutex::unlock()
 { 
+#ifdef TOOLS_MUTEX_PROFILING
+    profile.released();
+#endif
+
 #ifdef WIN32
     ReleaseMutex( mutex.handle );
 #else
@@ -89,12 +136,16 @@ bool Thread::Mutex::locked()
 #ifdef WIN32
     if( WaitForSingleObject( mutex.handle, 1L ) == WAIT_TIMEOUT )
     return true;
+
+    ReleaseMutex( mutex.handle );
 #else
     if( pthread_mutex_trylock( &mutex ) == EBUSY )
 	return true; 
+
+    // not via unlock(), this is no real acquisition
+    pthread_mutex_unlock( &mutex );
 #endif
-    
-    unlock(); 
+
     return false; 
 }
 
@@ -103,41 +154,111 @@ Thread::~Thread()
 
 }
 
+void Thread::setState( State s )
+{
+    // holding the lock, so a waiter cannot miss the notification
+    std::lock_guard<std::mutex> lock( m_state );
+    state.store( s, std::memory_order_release );
+    state_changed.notify_all();
+}
+
 void Thread::start()
 {
-    int sc = getStartCount();
+    setState( State::STARTING );
+    joined.store( false, std::memory_order_relaxed );
 
 #ifdef WIN32
     DWORD tid; // required on WIN9x (even if M$ says only "may" here)
     thread_handle = CreateThread( NULL, 0, run_thread, this, 0, &tid );
 #else
-    int rv = pthread_create( &thread, 0, run_thread, this );
+    pthread_attr_t attr;
+    pthread_attr_init( &attr );
+
+    int rv = 0;
+
+    if( options.stack_size > 0 ) {
+        rv = pthread_attr_setstacksize( &attr, options.stack_size );
+    }
+
+    if( rv == 0 && options.sched_policy >= 0 ) {
+        sched_param param {};
+        param.sched_priority = options.sched_priority;
+
+        rv = pthread_attr_setinheritsched( &attr, PTHREAD_EXPLICIT_SCHED );
+
+        if( rv == 0 ) {
+            rv = pthread_attr_setschedpolicy( &attr, options.sched_policy );
+        }
+
+        if( rv == 0 ) {
+            rv = pthread_attr_setschedparam( &attr, &param );
+        }
+    }
+
+#if defined(__linux__)
+    if( rv == 0 && ( !options.cpus.empty() || options.numa_node >= 0 ) ) {
+        std::vector<int> cpus = options.cpus;
+
+        if( options.numa_node >= 0 ) {
+            std::vector<int> node_cpus = CpuTopology::get().getNodeCpus( options.numa_node );
+
+            if( cpus.empty() ) {
+                cpus = node_cpus;
+            } else {
+                cpus.erase( std::remove_if( cpus.begin(), cpus.end(), [&node_cpus]( int cpu ) {
+                    return std::find( node_cpus.begin(), node_cpus.end(), cpu ) == node_cpus.end();
+                }), cpus.end() );
+            }
+        }
+
+        cpu_set_t set;
+        CPU_ZERO( &set );
+
+        for( int cpu : cpus ) {
+            if( cpu >= 0 && cpu < CPU_SETSIZE ) {
+                CPU_SET( cpu, &set );
+            }
+        }
+
+        if( CPU_COUNT( &set ) == 0 ) {
+            pthread_attr_destroy( &attr );
+            setState( State::CREATED );
+            joined.store( true, std::memory_order_relaxed );
+            throw REPORT_EXCEPTION( "no cpu left for the thread affinity" );
+        }
+
+        rv = pthread_attr_setaffinity_np( &attr, sizeof(set), &set );
+    }
+#endif
+
+    if( rv == 0 ) {
+        rv = pthread_create( &thread, &attr, run_thread, this );
+    }
+
+    pthread_attr_destroy( &attr );
+
     if( rv != 0 ) {
-         throw REPORT_EXCEPTION( format("error at pthread_create. rv: %d %s", rv, strerror(errno)) );
+         setState( State::CREATED );
+         joined.store( true, std::memory_order_relaxed );
+         throw REPORT_EXCEPTION( format("error at pthread_create. rv: %d %s", rv, strerror(rv)) );
     }
 #endif
 
     // wait until the thread runns
-    while( !running() && getStartCount() == sc )
+    std::unique_lock<std::mutex> lock( m_state );
+    state_changed.wait( lock, [this]() {
+        return state.load( std::memory_order_acquire ) != State::STARTING;
+    });
+}
+
+void Thread::wait()
+{
     {
-#ifdef WIN32
-    	Sleep(0);
-#else    
-		sched_yield();
-#endif
-    	if( isDone() ) {
-    		break;
-    	}
+        std::unique_lock<std::mutex> lock( m_state );
+        state_changed.wait( lock, [this]() { return finished(); } );
     }
-}
 
-int Thread::getStartCount()
-{ 
-    int r; 
-    m_start_count.lock(); 
-    r = start_count; 
-    m_start_count.unlock(); 
-    return r; 
+    join();
 }
 
 void Thread::exit()
@@ -149,29 +270,56 @@ void Thread::exit()
 #endif
 }
 
-bool Thread::isDone()
+void Thread::runThread()
 {
-    bool ret;
-    m_done.lock();
-    ret = done;
-    m_done.unlock();
-    return ret;
+    // also signals completion, if the thread is left via exit()
+    struct Completion
+    {
+        Thread & thread;
+
+        ~Completion() {
+            thread.start_count.fetch_sub( 1, std::memory_order_acq_rel );
+
+            if( thread.completion_callback ) {
+                thread.completion_callback( thread );
+            }
+
+            thread.setState( State::DONE );
+        }
+    };
+
+    applyOptions();
+
+    start_count.fetch_add( 1, std::memory_order_acq_rel );
+    setState( State::RUNNING );
+
+    Completion completion{ *this };
+    run();
 }
 
-void Thread::runThread()
-{ 
-    m_running.lock(); 
-    m_start_count.lock();
-    start_count++; 
-    m_start_count.unlock();
-    run(); 
-    m_start_count.lock();
-    start_count--;
-    m_start_count.unlock();
-    m_running.unlock(); 
-    m_done.lock();
-    done = true;
-    m_done.unlock();
+void Thread::applyOptions()
+{
+#if defined(__linux__)
+    if( !options.name.empty() ) {
+        // the kernel limits the name to 16 bytes, including the terminating 0
+        pthread_setname_np( pthread_self(), options.name.substr( 0, 15 ).c_str() );
+    }
+
+#  if defined(SYS_set_mempolicy)
+    if( options.numa_node >= 0 ) {
+        // MPOL_PREFERRED, the allocations are falling back to the
+        // other nodes, if the preferred one is full.
+        const int MPOL_PREFERRED_MODE = 1;
+        const unsigned long bits = sizeof(unsigned long) * 8;
+        std::vector<unsigned long> mask( options.numa_node / bits + 1, 0 );
+
+        mask[options.numa_node / bits] = 1UL << (options.numa_node % bits);
+
+        // ignoring errors, it's just a preference
+        syscall( SYS_set_mempolicy, MPOL_PREFERRED_MODE, mask.data(), mask.size() * bits + 1 );
+    }
+#  endif
+#endif
 }
 
 Thread::ThreadStruct Thread::current()
@@ -226,6 +374,11 @@ int Thread::processors()
 
 void Thread::join()
 {
+	// the thread was never started, or is already joined
+	if( joined.exchange( true, std::memory_order_acq_rel ) ) {
+		return;
+	}
+
 #ifdef WIN32
 	WaitForSingleObject(thread_handle, INFINITE);
 #else
@@ -10,16 +10,24 @@
 #  include <windows.h>
 #else
 # include <pthread.h>
+# include <unistd.h>
 #endif
 
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "mutex_profiler.h"
 
 namespace Tools {
 
 #ifdef WIN32
 inline void do_sleep( unsigned s ) { Sleep( s / 1000 ); }
 #else
-#include <unistd.h>
 inline void do_sleep( unsigned s ) { usleep( s ); }
 #endif
 
@@ -62,64 +70,213 @@ public:
 #endif
 
 	MutexStruct mutex;
+#ifdef TOOLS_MUTEX_PROFILING
+	MutexProfile profile;
+#endif
 
 	Mutex();
+	// the name is used by the mutex profiler only
+	explicit Mutex( const char *name );
 	~Mutex();
 
 	void lock();
+	bool try_lock();
 	void unlock();
 
 	bool locked();
     };	
 
+    /**
+     * Scoped lock for Thread::Mutex and every other mutex with
+     * lock() and unlock(), like AdaptiveMutex or SharedMutex:
+     *
+     *    Thread::MutexLock lock( mutex );
+     *
+     * The mutex type is only known to the constructor, the
+     * destructor unlocks it through a function pointer.
+     */
     class MutexLock
     {
     private:
-    	Mutex & mutex;
+    	void *mutex;
+    	void (*unlock_mutex)( void *mutex );
 
-    	MutexLock( const MutexLock & other ) : mutex(other.mutex){}
+    	MutexLock( const MutexLock & other ) : mutex(other.mutex), unlock_mutex(other.unlock_mutex) {}
     	MutexLock & operator=(  const MutexLock & other ) { return *this; }
+
+    	template<class M>
+    	static void unlock_it( void *mutex ) {
+    		static_cast<M*>( mutex )->unlock();
+    	}
+
     public:
-    	MutexLock( Mutex & mutex_ )
-    	: mutex( mutex_ )
+#ifdef TOOLS_MUTEX_PROFILING
+    	template<class M>
+    	MutexLock( M & mutex_, const std::source_location & location = std::source_location::current() )
+    	: mutex( &mutex_ ),
+    	  unlock_mutex( &unlock_it<M> )
+    	{
+    		if constexpr( requires { mutex_.profile; } ) {
+    			mutex_.profile.setLocation( location );
+    		}
+    		mutex_.lock();
+    	}
+#else
+    	template<class M>
+    	MutexLock( M & mutex_ )
+    	: mutex( &mutex_ ),
+    	  unlock_mutex( &unlock_it<M> )
     	{
-    		mutex.lock();
+    		mutex_.lock();
     	}
+#endif
 
     	~MutexLock()
     	{
-    		mutex.unlock();
+    		unlock_mutex( mutex );
+    	}
+    };
+
+    // Scoped lock for the reading side of a SharedMutex
+    class SharedMutexLock
+    {
+    private:
+    	void *mutex;
+    	void (*unlock_mutex)( void *mutex );
+
+    	SharedMutexLock( const SharedMutexLock & other ) = delete;
+    	SharedMutexLock & operator=(  const SharedMutexLock & other ) = delete;
+
+    	template<class M>
+    	static void unlock_it( void *mutex ) {
+    		static_cast<M*>( mutex )->unlock_shared();
+    	}
+
+    public:
+#ifdef TOOLS_MUTEX_PROFILING
+    	template<class M>
+    	SharedMutexLock( M & mutex_, const std::source_location & location = std::source_location::current() )
+    	: mutex( &mutex_ ),
+    	  unlock_mutex( &unlock_it<M> )
+    	{
+    		if constexpr( requires { mutex_.profile; } ) {
+    			mutex_.profile.setLocation( location );
+    		}
+    		mutex_.lock_shared();
+    	}
+#else
+    	template<class M>
+    	SharedMutexLock( M & mutex_ )
+    	: mutex( &mutex_ ),
+    	  unlock_mutex( &unlock_it<M> )
+    	{
+    		mutex_.lock_shared();
     	}
+#endif
+
+    	~SharedMutexLock()
+    	{
+    		unlock_mutex( mutex );
+    	}
+    };
+
+public:
+    enum class State
+    {
+        CREATED,
+        STARTING,
+        RUNNING,
+        DONE
+    };
+
+    // called from the thread itself, after run() returned
+    typedef std::function<void(Thread&)> CompletionCallback;
+
+    /**
+     * Applied by start(). See CpuTopology for choosing the cpus.
+     */
+    struct Options
+    {
+        std::vector<int> cpus;              // cpu affinity, empty: no restriction
+        int              numa_node = -1;    // restricts to the cpus of the node and prefers its memory
+        size_t           stack_size = 0;    // 0: system default
+        int              sched_policy = -1; // SCHED_OTHER, SCHED_FIFO, SCHED_RR; -1: inherited
+        int              sched_priority = 0;
+        std::string      name;              // only the first 15 characters are used
     };
 
 protected:
 
     ThreadStruct thread;
 
-    Mutex        m_running;
-    Mutex        m_start_count;
-    int          start_count;
-    Mutex        m_done;
-    bool         done;
+    std::atomic<State> state;
+    std::atomic<int>   start_count;
+    std::atomic<bool>  joined;
+
+    // only required for waiting on a state change
+    std::mutex              m_state;
+    std::condition_variable state_changed;
+
+    CompletionCallback      completion_callback;
+
+    Options                 options;
 
 public:
-    Thread() { start_count = 0; done = false; }
+    Thread() : state( State::CREATED ), start_count( 0 ), joined( true ) {}
     virtual ~Thread();
 
     virtual void run() = 0;
 
     ThreadStruct& getThread() { return thread; }
 
+    /**
+     * Starts the thread and returns if run() was entered.
+     * The caller is blocked on a condition, there is no busy waiting.
+     */
     void start();
-    bool running() { return m_running.locked(); }
-    void wait() { m_running.lock(); m_running.unlock(); join(); }
+    void start( const Options & options_ ) { options = options_; start(); }
+
+    void setOptions( const Options & options_ ) { options = options_; }
+    const Options & getOptions() const { return options; }
+    bool running() const { return state.load( std::memory_order_acquire ) == State::RUNNING; }
+    State getState() const { return state.load( std::memory_order_acquire ); }
+
+    // waits until run() returned and joins the thread
+    void wait();
+
+    /**
+     * Waits at most timeout until run() returned.
+     * returns true if the thread was finished and joined.
+     */
+    template<class Rep, class Period>
+    bool wait_for( const std::chrono::duration<Rep,Period> & timeout )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_state );
+
+            if( !state_changed.wait_for( lock, timeout, [this]() { return finished(); } ) ) {
+                return false;
+            }
+        }
+
+        join();
+        return true;
+    }
+
     void join();
-    int  getStartCount();
-    bool isDone();
+    int  getStartCount() const { return start_count.load( std::memory_order_acquire ); }
+    bool isDone() const { return state.load( std::memory_order_acquire ) == State::DONE; }
+
+    /**
+     * The callback is invoked on the thread, after run() returned and before
+     * the waiters are woken up. It must not destroy the Thread object.
+     * Has to be set before start().
+     */
+    void setCompletionCallback( CompletionCallback callback ) { completion_callback = std::move(callback); }
 
     static ThreadStruct current();
 
-    // return number of processors
+    // return number of processors, see CpuTopology for the details
     static int processors();
 
 #ifdef WIN32
@@ -134,6 +291,16 @@ protected:
 
 private:
 
+    bool finished() const {
+        State s = state.load( std::memory_order_acquire );
+        return s == State::DONE || s == State::CREATED;
+    }
+
+    void setState( State s );
+
+    // called from the thread itself
+    void applyOptions();
+
     void runThread();
 };
 
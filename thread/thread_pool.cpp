@@ -0,0 +1,316 @@
+#include "thread_pool.h"
+#include <cstdint>
+
+#ifdef TOOLS_USE_THREADS
+
+namespace Tools {
+
+namespace {
+
+thread_local ThreadPool *current_pool = nullptr;
+thread_local ThreadPool::WorkStealingDeque *current_deque = nullptr;
+
+// xorshift, to choose the victim for stealing
+inline unsigned next_random( unsigned & state )
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+} // namespace
+
+ThreadPool::WorkStealingDeque::WorkStealingDeque( int64_t capacity )
+{
+	// capacity has to be a power of 2
+	int64_t c = 1;
+	while( c < capacity ) {
+		c <<= 1;
+	}
+
+	arrays.push_back( std::make_unique<Array>( c ) );
+	array.store( arrays.back().get() );
+}
+
+void ThreadPool::WorkStealingDeque::push( Task *task )
+{
+	const int64_t b = bottom.load( std::memory_order_relaxed );
+	const int64_t t = top.load( std::memory_order_acquire );
+	Array *a = array.load( std::memory_order_relaxed );
+
+	if( b - t > a->capacity - 1 ) {
+		// grow, the old array is kept alive for the thieves
+		arrays.push_back( std::make_unique<Array>( a->capacity * 2 ) );
+		Array *bigger = arrays.back().get();
+
+		for( int64_t i = t; i < b; ++i ) {
+			bigger->put( i, a->get( i ) );
+		}
+
+		array.store( bigger, std::memory_order_release );
+		a = bigger;
+	}
+
+	a->put( b, task );
+	std::atomic_thread_fence( std::memory_order_release );
+	bottom.store( b + 1, std::memory_order_relaxed );
+}
+
+ThreadPool::Task *ThreadPool::WorkStealingDeque::pop()
+{
+	const int64_t b = bottom.load( std::memory_order_relaxed ) - 1;
+	Array *a = array.load( std::memory_order_relaxed );
+	bottom.store( b, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int64_t t = top.load( std::memory_order_relaxed );
+
+	if( t > b ) {
+		// empty
+		bottom.store( b + 1, std::memory_order_relaxed );
+		return nullptr;
+	}
+
+	Task *task = a->get( b );
+
+	if( t == b ) {
+		// last element, race against the thieves
+		if( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+			task = nullptr;
+		}
+		bottom.store( b + 1, std::memory_order_relaxed );
+	}
+
+	return task;
+}
+
+ThreadPool::Task *ThreadPool::WorkStealingDeque::steal()
+{
+	int64_t t = top.load( std::memory_order_acquire );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	const int64_t b = bottom.load( std::memory_order_acquire );
+
+	if( t >= b ) {
+		return nullptr;
+	}
+
+	Array *a = array.load( std::memory_order_acquire );
+	Task *task = a->get( t );
+
+	if( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+		// lost against an other thief, or the owner
+		return nullptr;
+	}
+
+	return task;
+}
+
+bool ThreadPool::WorkStealingDeque::empty() const
+{
+	return bottom.load( std::memory_order_relaxed ) <= top.load( std::memory_order_relaxed );
+}
+
+ThreadPool::ThreadPool( int threads )
+{
+	if( threads <= 0 ) {
+		threads = Thread::processors();
+	}
+
+	for( int i = 0; i < threads; ++i ) {
+		workers.push_back( std::make_unique<Worker>( *this ) );
+	}
+
+	for( auto & worker : workers ) {
+		worker->start();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	shutdown();
+}
+
+void ThreadPool::shutdown()
+{
+	{
+		// push() checks accepting with the same lock, so every task,
+		// that was queued, is queued before stopping is set
+		std::lock_guard<std::mutex> lock( injection_mutex );
+
+		if( !accepting.exchange( false ) ) {
+			return;
+		}
+	}
+
+	stopping = true;
+	signal.fetch_add( 1 );
+	signal.notify_all();
+
+	for( auto & worker : workers ) {
+		worker->join();
+	}
+
+	// nothing should be left, but no task may outlive the pool
+	while( Task *task = find_task( nullptr ) ) {
+		task->run();
+		delete task;
+	}
+}
+
+ThreadPool *ThreadPool::current()
+{
+	return current_pool;
+}
+
+void ThreadPool::push( Task *task )
+{
+	// tasks, that are running during shutdown(), may still submit work:
+	// a worker drains its own deque before it stops
+	if( current_pool == this ) {
+		current_deque->push( task );
+		wake_one();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( injection_mutex );
+
+		if( accepting.load() ) {
+			injection_queue.push_back( task );
+			injection_size.store( injection_queue.size(), std::memory_order_release );
+			task = nullptr;
+		}
+	}
+
+	if( task ) {
+		delete task;
+		throw REPORT_EXCEPTION( "ThreadPool is shut down" );
+	}
+
+	wake_one();
+}
+
+void ThreadPool::wake_one()
+{
+	signal.fetch_add( 1 );
+
+	if( sleepers.load() > 0 ) {
+		signal.notify_one();
+	}
+}
+
+ThreadPool::Task *ThreadPool::pop_injected()
+{
+	if( injection_size.load( std::memory_order_acquire ) == 0 ) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock( injection_mutex );
+
+	if( injection_queue.empty() ) {
+		return nullptr;
+	}
+
+	Task *task = injection_queue.front();
+	injection_queue.pop_front();
+	injection_size.store( injection_queue.size(), std::memory_order_release );
+
+	return task;
+}
+
+ThreadPool::Task *ThreadPool::find_task( Worker *self )
+{
+	if( self ) {
+		if( Task *task = self->deque.pop() ) {
+			return task;
+		}
+	}
+
+	if( Task *task = pop_injected() ) {
+		return task;
+	}
+
+	static thread_local unsigned random_state = 0x9e3779b9u ^ static_cast<unsigned>( reinterpret_cast<uintptr_t>( &random_state ) );
+
+	const size_t count = workers.size();
+	const size_t start = next_random( random_state ) % count;
+
+	for( size_t i = 0; i < count; ++i ) {
+		Worker *victim = workers[(start + i) % count].get();
+
+		if( victim == self ) {
+			continue;
+		}
+
+		if( Task *task = victim->deque.steal() ) {
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+bool ThreadPool::run_pending_task()
+{
+	Worker *self = nullptr;
+
+	if( current_pool == this ) {
+		for( auto & worker : workers ) {
+			if( &worker->deque == current_deque ) {
+				self = worker.get();
+				break;
+			}
+		}
+	}
+
+	Task *task = find_task( self );
+
+	if( !task ) {
+		return false;
+	}
+
+	task->run();
+	delete task;
+
+	return true;
+}
+
+void ThreadPool::Worker::run()
+{
+	current_pool = &pool;
+	current_deque = &deque;
+
+	while( true ) {
+		const unsigned seen = pool.signal.load();
+
+		if( Task *task = pool.find_task( this ) ) {
+			task->run();
+			delete task;
+			continue;
+		}
+
+		if( pool.stopping.load() ) {
+			// a task might have been queued between find_task() and
+			// setting stopping, after it nothing can be queued any more
+			if( Task *task = pool.find_task( this ) ) {
+				task->run();
+				delete task;
+				continue;
+			}
+
+			// all queues are drained
+			break;
+		}
+
+		pool.sleepers.fetch_add( 1 );
+		pool.signal.wait( seen );
+		pool.sleepers.fetch_sub( 1 );
+	}
+
+	current_pool = nullptr;
+	current_deque = nullptr;
+}
+
+} // namespace Tools
+
+#endif
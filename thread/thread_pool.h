@@ -0,0 +1,271 @@
+/**
+ * Work stealing thread pool
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::ThreadPool pool;
+ *
+ *    auto res = pool.submit( []() { return 42; } );
+ *    std::cout << res.get() << std::endl;
+ *
+ * Every worker has its own Chase-Lev deque. Tasks submitted from a worker
+ * are pushed onto its own deque, tasks from other threads are going
+ * through a shared injection queue. Idle workers are stealing from the others.
+ */
+#ifndef TOOLS_THREAD_POOL_H
+#define TOOLS_THREAD_POOL_H
+
+#include "thread.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace Tools {
+
+class ThreadPool
+{
+public:
+	class Task
+	{
+	public:
+		virtual ~Task() {}
+		virtual void run() = 0;
+	};
+
+	/**
+	 * Chase-Lev work stealing deque.
+	 * push() and pop() may only be called by the owner,
+	 * steal() from any thread.
+	 */
+	class WorkStealingDeque
+	{
+		struct Array
+		{
+			const int64_t capacity;
+			std::unique_ptr<std::atomic<Task*>[]> buffer;
+
+			explicit Array( int64_t capacity_ )
+			: capacity( capacity_ ),
+			  buffer( new std::atomic<Task*>[capacity_] )
+			{}
+
+			Task *get( int64_t pos ) const {
+				return buffer[pos & (capacity - 1)].load( std::memory_order_relaxed );
+			}
+
+			void put( int64_t pos, Task *task ) {
+				buffer[pos & (capacity - 1)].store( task, std::memory_order_relaxed );
+			}
+		};
+
+		alignas(64) std::atomic<int64_t> top = 0;
+		alignas(64) std::atomic<int64_t> bottom = 0;
+		std::atomic<Array*> array;
+
+		// replaced arrays, a thief might still read from them
+		std::vector<std::unique_ptr<Array>> arrays;
+
+	public:
+		explicit WorkStealingDeque( int64_t capacity = 256 );
+
+		WorkStealingDeque( const WorkStealingDeque & other ) = delete;
+		WorkStealingDeque & operator=( const WorkStealingDeque & other ) = delete;
+
+		void push( Task *task );
+		Task *pop();
+		Task *steal();
+
+		bool empty() const;
+	};
+
+	template <class T>
+	class Future;
+
+protected:
+	template <class T>
+	struct SharedState
+	{
+		std::atomic<bool> done = false;
+		std::optional<std::conditional_t<std::is_void<T>::value,bool,T>> value;
+		std::exception_ptr error;
+	};
+
+	template <class T, class Func>
+	class FuncTask : public Task
+	{
+		Func func;
+		std::shared_ptr<SharedState<T>> state;
+
+	public:
+		FuncTask( Func && func_, std::shared_ptr<SharedState<T>> state_ )
+		: func( std::move(func_) ),
+		  state( state_ )
+		{}
+
+		void run() override {
+			try {
+				if constexpr( std::is_void<T>::value ) {
+					func();
+				} else {
+					state->value.emplace( func() );
+				}
+			} catch( ... ) {
+				state->error = std::current_exception();
+			}
+
+			state->done.store( true, std::memory_order_release );
+			state->done.notify_all();
+		}
+	};
+
+	class Worker : public Thread
+	{
+		ThreadPool & pool;
+
+	public:
+		WorkStealingDeque deque;
+
+		explicit Worker( ThreadPool & pool_ )
+		: pool( pool_ )
+		{}
+
+		void run() override;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::mutex injection_mutex;
+	std::deque<Task*> injection_queue;
+	std::atomic<size_t> injection_size = 0;
+
+	alignas(64) std::atomic<unsigned> signal = 0;
+	std::atomic<unsigned> sleepers = 0;
+	std::atomic<bool> accepting = true;
+	std::atomic<bool> stopping = false;
+
+public:
+	// threads <= 0: one worker per processor
+	explicit ThreadPool( int threads = 0 );
+
+	ThreadPool( const ThreadPool & other ) = delete;
+	ThreadPool & operator=( const ThreadPool & other ) = delete;
+
+	// calls shutdown()
+	~ThreadPool();
+
+	size_t size() const {
+		return workers.size();
+	}
+
+	/**
+	 * Queues func() and returns a handle to its result.
+	 * throws an exception after shutdown() was called,
+	 * unless it is called by a task of this pool.
+	 */
+	template <class Func>
+	Future<std::invoke_result_t<std::decay_t<Func>>> submit( Func && func ) {
+		typedef std::invoke_result_t<std::decay_t<Func>> T;
+
+		auto state = std::make_shared<SharedState<T>>();
+		push( new FuncTask<T,std::decay_t<Func>>( std::decay_t<Func>( std::forward<Func>(func) ), state ) );
+
+		return Future<T>( this, state );
+	}
+
+	/**
+	 * Stops accepting new tasks from other threads, runs all the
+	 * queued tasks, including the ones they are submitting,
+	 * and waits until all workers are finished. Every task, that
+	 * was accepted, has run when it returns.
+	 */
+	void shutdown();
+
+	/**
+	 * Runs one queued task on the calling thread.
+	 * returns false if no task was found.
+	 */
+	bool run_pending_task();
+
+	// the pool of the calling worker thread, nullptr for other threads
+	static ThreadPool *current();
+
+protected:
+	void push( Task *task );
+	Task *find_task( Worker *self );
+	Task *pop_injected();
+	void wake_one();
+
+	friend class Worker;
+};
+
+/**
+ * Handle to the result of a submitted task.
+ * If get() or wait() are called from a worker thread of the same
+ * pool, the worker is running other tasks meanwhile.
+ */
+template <class T>
+class ThreadPool::Future
+{
+	ThreadPool *pool = nullptr;
+	std::shared_ptr<SharedState<T>> state;
+
+public:
+	Future() = default;
+
+	Future( ThreadPool *pool_, std::shared_ptr<SharedState<T>> state_ )
+	: pool( pool_ ),
+	  state( state_ )
+	{}
+
+	bool valid() const {
+		return state != nullptr;
+	}
+
+	bool ready() const {
+		return state->done.load( std::memory_order_acquire );
+	}
+
+	void wait() const {
+		while( !ready() ) {
+			if( ThreadPool::current() == pool && pool->run_pending_task() ) {
+				continue;
+			}
+
+			// nothing to help with, the task is running on an other thread
+			state->done.wait( false, std::memory_order_acquire );
+		}
+	}
+
+	/**
+	 * returns the result, or rethrows the exception of the task.
+	 * can only be called once.
+	 */
+	T get() {
+		wait();
+
+		std::shared_ptr<SharedState<T>> s = std::move(state);
+
+		if( s->error ) {
+			std::rethrow_exception( s->error );
+		}
+
+		if constexpr( !std::is_void<T>::value ) {
+			return std::move( *s->value );
+		}
+	}
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
@@ -0,0 +1,382 @@
+#include "timer_service.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <CpputilsDebug.h>
+#include <algorithm>
+
+namespace Tools {
+
+TimerService::TimerService( Clock::duration tick_, ThreadPool *pool_ )
+: tick( std::max( tick_, Clock::duration(1) ) ),
+  start_time( Clock::now() ),
+  pool( pool_ ),
+  worker( *this )
+{
+	Thread::Options options;
+	options.name = "timer-service";
+	worker.start( options );
+}
+
+TimerService::~TimerService()
+{
+	stop();
+}
+
+void TimerService::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stopping = true;
+		changed.notify_all();
+	}
+
+	worker.wait();
+
+	std::lock_guard<std::mutex> lock( mutex );
+
+	nodes.clear();
+	free_list = NIL;
+	levels = {};
+	count = 0;
+}
+
+uint64_t TimerService::to_tick( Clock::time_point tp ) const
+{
+	if( tp <= start_time ) {
+		return 0;
+	}
+
+	return static_cast<uint64_t>( (tp - start_time) / tick );
+}
+
+uint64_t TimerService::to_tick_ceil( Clock::time_point tp ) const
+{
+	uint64_t t = to_tick( tp );
+
+	if( to_time( t ) < tp ) {
+		++t;
+	}
+
+	return t;
+}
+
+TimerService::Clock::time_point TimerService::to_time( uint64_t t ) const
+{
+	return start_time + tick * static_cast<Clock::rep>( t );
+}
+
+TimerService::TimerId TimerService::schedule_at( Clock::time_point deadline, Callback callback )
+{
+	// rounding up, a timer never fires too early
+	const uint64_t expiry = to_tick_ceil( deadline );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	return add( expiry, 0, std::move(callback) );
+}
+
+TimerService::TimerId TimerService::schedule_periodic( Clock::duration period, Callback callback )
+{
+	const uint64_t period_ticks = std::max<uint64_t>( 1, (period + tick - Clock::duration(1)) / tick );
+	// the first deadline is rounded up, like the one of schedule_at()
+	const uint64_t expiry = to_tick_ceil( Clock::now() + period );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	return add( expiry, period_ticks, std::move(callback) );
+}
+
+TimerService::TimerId TimerService::add( uint64_t expiry, uint64_t period, Callback && callback )
+{
+	if( stopping ) {
+		throw REPORT_EXCEPTION( "TimerService is already stopped" );
+	}
+
+	// while idle the wheel is not moved forward
+	if( count == 0 ) {
+		now_tick = std::max( now_tick, to_tick( Clock::now() ) );
+	}
+
+	expiry = std::max( expiry, now_tick + 1 );
+
+	const uint32_t idx = alloc_node();
+	Node & node = nodes[idx];
+
+	node.in_use = true;
+	node.expiry = expiry;
+	node.period = period;
+	node.callback = std::move(callback);
+
+	link( idx );
+	++count;
+
+	if( expiry < wakeup_tick ) {
+		changed.notify_one();
+	}
+
+	return make_id( idx, node.generation );
+}
+
+bool TimerService::cancel( TimerId id )
+{
+	const uint64_t idx = (id & 0xffffffff) - 1;
+	const uint32_t generation = static_cast<uint32_t>( id >> 32 );
+
+	std::lock_guard<std::mutex> lock( mutex );
+
+	if( id == 0 || idx >= nodes.size() ) {
+		return false;
+	}
+
+	Node & node = nodes[idx];
+
+	if( !node.in_use || node.generation != generation ) {
+		return false;
+	}
+
+	unlink( idx );
+	free_node( idx );
+	--count;
+
+	return true;
+}
+
+size_t TimerService::size() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return count;
+}
+
+uint32_t TimerService::alloc_node()
+{
+	if( free_list != NIL ) {
+		uint32_t idx = free_list;
+		free_list = nodes[idx].next;
+		return idx;
+	}
+
+	nodes.emplace_back();
+	return static_cast<uint32_t>( nodes.size() - 1 );
+}
+
+void TimerService::free_node( uint32_t idx )
+{
+	Node & node = nodes[idx];
+
+	node.in_use = false;
+	node.callback = nullptr;
+	// so old ids are not matching any more
+	++node.generation;
+
+	node.prev = NIL;
+	node.next = free_list;
+	free_list = idx;
+}
+
+void TimerService::link( uint32_t idx )
+{
+	Node & node = nodes[idx];
+
+	uint64_t t = node.expiry;
+	const uint64_t delta = t - now_tick;
+	unsigned level = 0;
+
+	while( level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))) ) {
+		++level;
+	}
+
+	// beyond the range of the wheel, it will be cascaded again
+	if( level == LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * LEVELS)) ) {
+		t = now_tick + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+	}
+
+	const unsigned slot = (t >> (SLOT_BITS * level)) & SLOT_MASK;
+	Level & l = levels[level];
+
+	node.level = level;
+	node.slot = slot;
+	node.prev = NIL;
+	node.next = l.heads[slot];
+
+	if( node.next != NIL ) {
+		nodes[node.next].prev = idx;
+	}
+
+	l.heads[slot] = idx;
+	l.occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+void TimerService::unlink( uint32_t idx )
+{
+	Node & node = nodes[idx];
+	Level & l = levels[node.level];
+
+	if( node.prev == NIL ) {
+		l.heads[node.slot] = node.next;
+	} else {
+		nodes[node.prev].next = node.next;
+	}
+
+	if( node.next != NIL ) {
+		nodes[node.next].prev = node.prev;
+	}
+
+	if( l.heads[node.slot] == NIL ) {
+		l.occupied[node.slot / 64] &= ~(uint64_t(1) << (node.slot % 64));
+	}
+
+	node.prev = NIL;
+	node.next = NIL;
+}
+
+void TimerService::cascade( unsigned level, unsigned slot )
+{
+	Level & l = levels[level];
+	uint32_t idx = l.heads[slot];
+
+	l.heads[slot] = NIL;
+	l.occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+
+	while( idx != NIL ) {
+		uint32_t next = nodes[idx].next;
+		link( idx );
+		idx = next;
+	}
+}
+
+void TimerService::advance( uint64_t target, std::vector<uint32_t> & expired )
+{
+	if( count == 0 ) {
+		now_tick = std::max( now_tick, target );
+		return;
+	}
+
+	while( now_tick < target ) {
+		++now_tick;
+
+		// moving the timers of the next higher level down
+		for( unsigned level = 1; level < LEVELS; ++level ) {
+			const unsigned shift = SLOT_BITS * level;
+
+			if( (now_tick & ((uint64_t(1) << shift) - 1)) != 0 ) {
+				break;
+			}
+
+			cascade( level, (now_tick >> shift) & SLOT_MASK );
+		}
+
+		const unsigned slot = now_tick & SLOT_MASK;
+		Level & l = levels[0];
+		uint32_t idx = l.heads[slot];
+
+		l.heads[slot] = NIL;
+		l.occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+
+		while( idx != NIL ) {
+			uint32_t next = nodes[idx].next;
+			nodes[idx].prev = NIL;
+			nodes[idx].next = NIL;
+			expired.push_back( idx );
+			idx = next;
+		}
+	}
+}
+
+uint64_t TimerService::next_expiry() const
+{
+	if( count == 0 ) {
+		return UINT64_MAX;
+	}
+
+	uint64_t res = UINT64_MAX;
+	const Level & l0 = levels[0];
+
+	for( uint64_t t = now_tick + 1; t < now_tick + SLOTS; ++t ) {
+		const unsigned slot = t & SLOT_MASK;
+
+		if( l0.occupied[slot / 64] & (uint64_t(1) << (slot % 64)) ) {
+			res = t;
+			break;
+		}
+	}
+
+	// the next cascade may bring timers down
+	for( unsigned level = 1; level < LEVELS; ++level ) {
+		for( uint64_t bits : levels[level].occupied ) {
+			if( bits ) {
+				return std::min( res, (now_tick | SLOT_MASK) + 1 );
+			}
+		}
+	}
+
+	return res;
+}
+
+void TimerService::run()
+{
+	std::vector<uint32_t> expired;
+	std::vector<Callback> callbacks;
+
+	std::unique_lock<std::mutex> lock( mutex );
+
+	while( !stopping ) {
+		advance( to_tick( Clock::now() ), expired );
+
+		for( uint32_t idx : expired ) {
+			Node & node = nodes[idx];
+
+			if( node.period > 0 ) {
+				callbacks.push_back( node.callback );
+
+				// drift free, missed periods are skipped
+				node.expiry += node.period;
+
+				if( node.expiry <= now_tick ) {
+					node.expiry += ((now_tick - node.expiry) / node.period + 1) * node.period;
+				}
+
+				link( idx );
+			} else {
+				callbacks.push_back( std::move(node.callback) );
+				free_node( idx );
+				--count;
+			}
+		}
+
+		expired.clear();
+
+		if( !callbacks.empty() ) {
+			lock.unlock();
+
+			for( Callback & callback : callbacks ) {
+				if( pool ) {
+					pool->submit( std::move(callback) );
+					continue;
+				}
+
+				try {
+					callback();
+				} catch( const std::exception & error ) {
+					CPPDEBUG( format( "exception in timer callback: %s", error.what() ) );
+				}
+			}
+
+			callbacks.clear();
+			lock.lock();
+			continue;
+		}
+
+		wakeup_tick = next_expiry();
+
+		if( wakeup_tick == UINT64_MAX ) {
+			changed.wait( lock );
+		} else {
+			changed.wait_until( lock, to_time( wakeup_tick ) );
+		}
+
+		wakeup_tick = UINT64_MAX;
+	}
+}
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
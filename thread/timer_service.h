@@ -0,0 +1,186 @@
+/**
+ * Timer service on a hierarchical timing wheel
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    Tools::TimerService timers;
+ *
+ *    auto id = timers.schedule_after( std::chrono::seconds(30), [conn]() { conn->close_idle(); } );
+ *    ...
+ *    timers.cancel( id );
+ *
+ *    // drift free, the n-th call is due at start + n * period
+ *    timers.schedule_every( std::chrono::milliseconds(100), []() { flush_stats(); } );
+ *
+ * All timers are handled by one thread, that sleeps until the next
+ * timer is due. Scheduling and cancelling are O(1), so hundreds of
+ * thousands of pending timeouts are cheap.
+ *
+ * The callbacks are executed on the timer thread, so they should be short.
+ * If a ThreadPool is passed, the callbacks are submitted to the pool instead.
+ *
+ * The resolution is one tick (default 1ms). Timers never fire early.
+ */
+#ifndef TOOLS_TIMER_SERVICE_H
+#define TOOLS_TIMER_SERVICE_H
+
+#include "thread_pool.h"
+
+#ifdef TOOLS_USE_THREADS
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Tools {
+
+class TimerService
+{
+public:
+	typedef std::function<void()> Callback;
+	typedef std::chrono::steady_clock Clock;
+
+	// 0 is never a valid id
+	typedef uint64_t TimerId;
+
+protected:
+	static constexpr unsigned LEVELS     = 4;
+	static constexpr unsigned SLOT_BITS  = 8;
+	static constexpr unsigned SLOTS      = 1 << SLOT_BITS;
+	static constexpr uint64_t SLOT_MASK  = SLOTS - 1;
+	static constexpr uint32_t NIL        = UINT32_MAX;
+
+	struct Node
+	{
+		uint32_t prev = NIL;
+		uint32_t next = NIL;
+		uint32_t generation = 1;
+		uint16_t level = 0;
+		uint16_t slot = 0;
+		bool     in_use = false;
+		uint64_t expiry = 0;    // in ticks
+		uint64_t period = 0;    // in ticks, 0: one shot
+		Callback callback;
+	};
+
+	struct Level
+	{
+		std::array<uint32_t,SLOTS> heads;
+		std::array<uint64_t,SLOTS / 64> occupied;
+
+		Level() {
+			heads.fill( NIL );
+			occupied.fill( 0 );
+		}
+	};
+
+	class Worker : public Thread
+	{
+		TimerService & service;
+
+	public:
+		explicit Worker( TimerService & service_ )
+		: service( service_ )
+		{}
+
+		void run() override {
+			service.run();
+		}
+	};
+
+	const Clock::duration tick;
+	const Clock::time_point start_time;
+	ThreadPool *pool;
+
+	mutable std::mutex      mutex;
+	std::condition_variable changed;
+
+	std::vector<Node>       nodes;
+	uint32_t                free_list = NIL;
+	std::array<Level,LEVELS> levels;
+	size_t                  count = 0;
+	uint64_t                now_tick = 0;
+
+	// the tick the thread is sleeping until, UINT64_MAX: no timer
+	uint64_t                wakeup_tick = UINT64_MAX;
+	bool                    stopping = false;
+
+	Worker                  worker;
+
+public:
+	/**
+	 * tick:  resolution of the timers
+	 * pool:  if set, the callbacks are executed on the pool
+	 */
+	explicit TimerService( Clock::duration tick = std::chrono::milliseconds(1), ThreadPool *pool = nullptr );
+
+	TimerService( const TimerService & other ) = delete;
+	TimerService & operator=( const TimerService & other ) = delete;
+
+	// calls stop()
+	~TimerService();
+
+	TimerId schedule_at( Clock::time_point deadline, Callback callback );
+
+	template <class Rep, class Period>
+	TimerId schedule_after( const std::chrono::duration<Rep,Period> & delay, Callback callback ) {
+		return schedule_at( Clock::now() + std::chrono::duration_cast<Clock::duration>( delay ), std::move(callback) );
+	}
+
+	template <class Rep, class Period>
+	TimerId schedule_every( const std::chrono::duration<Rep,Period> & period, Callback callback ) {
+		return schedule_periodic( std::chrono::duration_cast<Clock::duration>( period ), std::move(callback) );
+	}
+
+	/**
+	 * returns false, if the timer was already fired or cancelled.
+	 * A periodic timer can also be cancelled from its own callback.
+	 */
+	bool cancel( TimerId id );
+
+	// number of pending timers
+	size_t size() const;
+
+	/**
+	 * stops the timer thread, pending timers are dropped.
+	 * Callbacks, that were already submitted to the pool are not affected.
+	 */
+	void stop();
+
+protected:
+	void run();
+
+	TimerId schedule_periodic( Clock::duration period, Callback callback );
+	TimerId add( uint64_t expiry, uint64_t period, Callback && callback );
+
+	uint64_t to_tick( Clock::time_point tp ) const;
+	// the first tick, that is not before tp
+	uint64_t to_tick_ceil( Clock::time_point tp ) const;
+	Clock::time_point to_time( uint64_t tick ) const;
+
+	uint32_t alloc_node();
+	void free_node( uint32_t idx );
+
+	void link( uint32_t idx );
+	void unlink( uint32_t idx );
+	void cascade( unsigned level, unsigned slot );
+
+	// moves the wheel forward, the expired nodes are appended
+	void advance( uint64_t target, std::vector<uint32_t> & expired );
+
+	uint64_t next_expiry() const;
+
+	static TimerId make_id( uint32_t idx, uint32_t generation ) {
+		return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(idx) + 1);
+	}
+};
+
+} // namespace Tools
+
+#endif // TOOLS_USE_THREADS
+
+#endif
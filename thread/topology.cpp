@@ -0,0 +1,266 @@
+#include "topology.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#ifndef WIN32
+#  include <unistd.h>
+#endif
+
+namespace Tools {
+
+namespace {
+
+const char *SYS_CPU  = "/sys/devices/system/cpu";
+const char *SYS_NODE = "/sys/devices/system/node";
+
+bool read_line( const std::string & file_name, std::string & line )
+{
+	std::ifstream in( file_name );
+
+	if( !in ) {
+		return false;
+	}
+
+	return static_cast<bool>( std::getline( in, line ) );
+}
+
+bool read_int( const std::string & file_name, int & value )
+{
+	std::string line;
+
+	if( !read_line( file_name, line ) ) {
+		return false;
+	}
+
+	std::stringstream str( line );
+	return static_cast<bool>( str >> value );
+}
+
+int online_processors()
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+	long res = sysconf( _SC_NPROCESSORS_ONLN );
+	if( res > 0 ) {
+		return static_cast<int>(res);
+	}
+#endif
+	return 1;
+}
+
+} // namespace
+
+std::vector<int> CpuTopology::parseCpuList( const std::string & list )
+{
+	std::vector<int> res;
+	std::stringstream str( list );
+	std::string range;
+
+	while( std::getline( str, range, ',' ) ) {
+		// strip the trailing newline or spaces
+		while( !range.empty() && (range.back() == '\n' || range.back() == ' ') ) {
+			range.pop_back();
+		}
+
+		if( range.empty() ) {
+			continue;
+		}
+
+		int first = 0;
+		int last = 0;
+		char dash = 0;
+		std::stringstream r( range );
+
+		if( !(r >> first) ) {
+			return {};
+		}
+
+		last = first;
+
+		if( r >> dash ) {
+			if( dash != '-' || !(r >> last) || last < first ) {
+				return {};
+			}
+		}
+
+		for( int i = first; i <= last; ++i ) {
+			res.push_back( i );
+		}
+	}
+
+	return res;
+}
+
+CpuTopology::CpuTopology()
+{
+	std::string online;
+	std::vector<int> ids;
+
+	if( read_line( std::string(SYS_CPU) + "/online", online ) ) {
+		ids = parseCpuList( online );
+	}
+
+	if( ids.empty() ) {
+		for( int i = 0; i < online_processors(); ++i ) {
+			ids.push_back( i );
+		}
+	}
+
+	// (package,core_id) => unique core number
+	std::map<std::pair<int,int>,int> core_numbers;
+	std::map<int,int> package_numbers;
+
+	for( int id : ids ) {
+		Cpu cpu;
+		cpu.id = id;
+
+		const std::string topo = std::string(SYS_CPU) + "/cpu" + std::to_string(id) + "/topology/";
+
+		int core_id = id;
+		int package_id = 0;
+
+		read_int( topo + "core_id", core_id );
+		read_int( topo + "physical_package_id", package_id );
+
+		auto pit = package_numbers.emplace( package_id, static_cast<int>(package_numbers.size()) ).first;
+		cpu.package = pit->second;
+
+		auto cit = core_numbers.emplace( std::make_pair( package_id, core_id ), static_cast<int>(core_numbers.size()) ).first;
+		cpu.core = cit->second;
+
+		std::string siblings;
+
+		if( read_line( topo + "thread_siblings_list", siblings ) ) {
+			cpu.siblings = parseCpuList( siblings );
+		}
+
+		if( cpu.siblings.empty() ) {
+			cpu.siblings.push_back( id );
+		}
+
+		cpus.push_back( cpu );
+	}
+
+	cores = static_cast<int>(core_numbers.size());
+	packages = static_cast<int>(package_numbers.size());
+
+	// NUMA nodes, the ids may have gaps
+	std::string online_nodes;
+
+	if( read_line( std::string(SYS_NODE) + "/online", online_nodes ) ) {
+		for( int node : parseCpuList( online_nodes ) ) {
+			std::string list;
+
+			if( !read_line( std::string(SYS_NODE) + "/node" + std::to_string(node) + "/cpulist", list ) ) {
+				continue;
+			}
+
+			std::vector<int> node_cpus = parseCpuList( list );
+
+			for( Cpu & cpu : cpus ) {
+				if( std::find( node_cpus.begin(), node_cpus.end(), cpu.id ) != node_cpus.end() ) {
+					cpu.node = node;
+				}
+			}
+
+			nodes[node] = node_cpus;
+		}
+	}
+
+	if( nodes.empty() ) {
+		nodes[0] = ids;
+	}
+}
+
+const CpuTopology & CpuTopology::get()
+{
+	static const CpuTopology topology;
+	return topology;
+}
+
+const CpuTopology::Cpu *CpuTopology::getCpu( int id ) const
+{
+	for( const Cpu & cpu : cpus ) {
+		if( cpu.id == id ) {
+			return &cpu;
+		}
+	}
+
+	return nullptr;
+}
+
+std::vector<int> CpuTopology::getNodeIds() const
+{
+	std::vector<int> res;
+
+	for( const auto & node : nodes ) {
+		res.push_back( node.first );
+	}
+
+	return res;
+}
+
+std::vector<int> CpuTopology::getNodeCpus( int node ) const
+{
+	auto it = nodes.find( node );
+
+	if( it == nodes.end() ) {
+		return {};
+	}
+
+	return it->second;
+}
+
+std::vector<int> CpuTopology::getSiblings( int id ) const
+{
+	if( const Cpu *cpu = getCpu( id ) ) {
+		return cpu->siblings;
+	}
+
+	return {};
+}
+
+std::vector<int> CpuTopology::getOneCpuPerCore() const
+{
+	std::vector<int> res;
+	std::vector<bool> seen( cores, false );
+
+	for( const Cpu & cpu : cpus ) {
+		if( !seen[cpu.core] ) {
+			seen[cpu.core] = true;
+			res.push_back( cpu.id );
+		}
+	}
+
+	return res;
+}
+
+std::string CpuTopology::toString() const
+{
+	std::stringstream str;
+
+	str << "cpus: " << cpus.size()
+		<< " cores: " << cores
+		<< " packages: " << packages
+		<< " nodes: " << nodes.size() << "\n";
+
+	for( const Cpu & cpu : cpus ) {
+		str << "cpu " << cpu.id
+			<< " core " << cpu.core
+			<< " package " << cpu.package
+			<< " node " << cpu.node
+			<< " siblings";
+
+		for( int s : cpu.siblings ) {
+			str << " " << s;
+		}
+
+		str << "\n";
+	}
+
+	return str.str();
+}
+
+} // namespace Tools
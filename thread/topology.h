@@ -0,0 +1,98 @@
+/**
+ * CPU topology of the machine, read from /sys
+ * @author Copyright (c) 2026 Martin Oberzalek
+ *
+ * Examples:
+ *    const Tools::CpuTopology & topo = Tools::CpuTopology::get();
+ *
+ *    // one thread per physical core, skipping the SMT siblings
+ *    for( int cpu : topo.getOneCpuPerCore() ) { ... }
+ *
+ *    // all cpus of NUMA node 1
+ *    std::vector<int> cpus = topo.getNodeCpus( 1 );
+ *
+ * Nodes are identified by their kernel id, see getNodeIds().
+ * No libnuma is required. If /sys is not available, every online
+ * processor is reported as its own core on node 0.
+ */
+#ifndef TOOLS_TOPOLOGY_H
+#define TOOLS_TOPOLOGY_H
+
+#include <vector>
+#include <string>
+#include <map>
+
+namespace Tools {
+
+class CpuTopology
+{
+public:
+	struct Cpu
+	{
+		int id      = 0;
+		int core    = 0;   // unique over all packages
+		int package = 0;
+		int node    = 0;
+		std::vector<int> siblings;  // SMT siblings, including the cpu itself
+	};
+
+protected:
+	std::vector<Cpu> cpus;
+	// node id => cpus
+	std::map<int,std::vector<int>> nodes;
+	int cores = 0;
+	int packages = 0;
+
+public:
+	// reads the topology every time
+	CpuTopology();
+
+	// the topology, read once
+	static const CpuTopology & get();
+
+	const std::vector<Cpu> & getCpus() const {
+		return cpus;
+	}
+
+	// nullptr, if the cpu is not online
+	const Cpu *getCpu( int id ) const;
+
+	size_t getCpuCount() const {
+		return cpus.size();
+	}
+
+	int getCoreCount() const {
+		return cores;
+	}
+
+	int getPackageCount() const {
+		return packages;
+	}
+
+	int getNodeCount() const {
+		return static_cast<int>(nodes.size());
+	}
+
+	// the ids of the online nodes, they are not always consecutive
+	std::vector<int> getNodeIds() const;
+
+	// node is the id of the node, empty if it is unknown
+	std::vector<int> getNodeCpus( int node ) const;
+
+	std::vector<int> getSiblings( int cpu ) const;
+
+	// the first cpu of each core
+	std::vector<int> getOneCpuPerCore() const;
+
+	/**
+	 * parses the /sys list format: "0-3,8,10-11"
+	 * returns an empty vector on errors
+	 */
+	static std::vector<int> parseCpuList( const std::string & list );
+
+	std::string toString() const;
+};
+
+} // namespace Tools
+
+#endif